@@ -0,0 +1,353 @@
+#include <cerrno>
+#include <cstdio>
+#include <cstring>
+#include <fcntl.h>
+#include <iostream>
+#include <memory>
+#include <thread>
+#include <unistd.h>
+#include "batch.h"
+#include "block.h"
+#include "errors.h"
+#include "tools.h"
+#include "uring.h"
+
+//operations of a file in flight, kept in the low bits of the ring tags
+enum BatchOperation {
+  OPEN_INPUT, OPEN_OUTPUT, READ, WRITE, CLOSE
+};
+
+int const OPERATION_BITS = 3;
+
+//file in flight on a worker thread, using registered buffer number index
+struct BatchSlot {
+
+  int index;
+  size_t job;
+  bool active = false;
+
+  std::string input_path;
+  std::string output_path;
+  //the output is written here and renamed to output_path once complete,
+  //so that no output is ever left truncated
+  std::string temporary_path;
+  int input_fd;
+  int output_fd;
+
+  //offsets of the next read and write
+  uint64_t input_offset;
+  uint64_t output_offset;
+
+  //encrypted symbols in the buffer and how many of them are written
+  unsigned length;
+  unsigned written;
+
+  //operations outstanding (opens and closes go in pairs)
+  int pending;
+
+  MachineState machine;
+
+  int errorcode;
+  int system_error;
+  char bad_letter;
+
+};
+
+BatchEncryptor::BatchEncryptor(const std::string& input_dir,
+                               const std::string& output_dir,
+                               const std::vector<BatchJob>& jobs,
+                               const std::vector<MachineState>& keys,
+                               int depth)
+  : input_dir(input_dir), output_dir(output_dir), jobs(jobs), keys(keys),
+    depth(depth)
+{
+}
+
+//helper function to encrypt a piece of a file in place
+//returns the number of encrypted symbols, or -1 (with bad_letter set) if
+//a letter machine finds an invalid character
+static int encrypt_piece(BlockEngine& engine, MachineState& machine,
+                         char buffer[], int length, char& bad_letter)
+{
+#ifdef BYTE_ALPHABET
+  //every byte is a symbol, so there is no invalid character to report
+  (void) bad_letter;
+  engine.encrypt(machine, (const symbol*) buffer, (symbol*) buffer, length);
+  return length;
+#else
+  int kept = 0;
+  for (int i = 0; i < length; i++)
+    {
+      char letter = buffer[i];
+      if (letter == ' ' || letter == '\n' || letter == '\r' || letter == '\t'
+          || letter == '\v' || letter == '\f')
+        continue;
+      if (letter < 'A' || letter > 'Z')
+        {
+          bad_letter = letter;
+          return -1;
+        }
+      buffer[kept++] = letter;
+    }
+  engine.encrypt(machine, (const symbol*) buffer, (symbol*) buffer, kept);
+  return kept;
+#endif
+}
+
+void BatchEncryptor::worker()
+{
+  IoRing ring(2 * depth);
+  if (!ring.is_native())
+    native = false;
+
+  std::vector<char> memory((size_t) depth * BATCH_BUFFER_SIZE);
+  std::vector<iovec> buffers(depth);
+  std::vector<BatchSlot> slots(depth);
+
+  //block engines of the keys used on this thread, made on first use
+  std::vector<std::unique_ptr<BlockEngine>> engines(keys.size());
+  for (int i = 0; i < depth; i++)
+    {
+      buffers[i].iov_base = &memory[(size_t) i * BATCH_BUFFER_SIZE];
+      buffers[i].iov_len = BATCH_BUFFER_SIZE;
+      slots[i].index = i;
+    }
+  ring.register_buffers(buffers.data(), depth);
+
+  auto tag = [](const BatchSlot& slot, BatchOperation operation)
+    {
+      return ((uint64_t) slot.index << OPERATION_BITS) | operation;
+    };
+
+  auto read = [&](BatchSlot& slot)
+    {
+      ring.read_fixed(slot.input_fd, buffers[slot.index].iov_base,
+                      BATCH_BUFFER_SIZE, slot.input_offset, slot.index,
+                      tag(slot, READ));
+    };
+
+  auto write = [&](BatchSlot& slot)
+    {
+      ring.write_fixed(slot.output_fd,
+                       (char*) buffers[slot.index].iov_base + slot.written,
+                       slot.length - slot.written, slot.output_offset,
+                       slot.index, tag(slot, WRITE));
+    };
+
+  //start the next job on a slot, leaving it inactive when there is none
+  auto start = [&](BatchSlot& slot)
+    {
+      slot.job = next_job++;
+      slot.active = slot.job < jobs.size();
+      if (!slot.active)
+        return;
+
+      const BatchJob& job = jobs[slot.job];
+      slot.input_path = input_dir + "/" + job.name;
+      slot.output_path = output_dir + "/" + job.name;
+      slot.temporary_path = slot.output_path + ".tmp";
+      slot.input_fd = slot.output_fd = -1;
+      slot.input_offset = slot.output_offset = 0;
+      slot.machine = keys[job.key];
+      slot.errorcode = NO_ERROR;
+      slot.system_error = 0;
+      slot.pending = 2;
+      ring.openat(slot.input_path.c_str(), O_RDONLY, 0, tag(slot, OPEN_INPUT));
+      ring.openat(slot.temporary_path.c_str(), O_WRONLY | O_CREAT | O_TRUNC,
+                  0644, tag(slot, OPEN_OUTPUT));
+    };
+
+  //close the files of a slot, or report it and start the next job once
+  //they are closed
+  auto finish = [&](BatchSlot& slot)
+    {
+      if (slot.input_fd >= 0 || slot.output_fd >= 0)
+        {
+          slot.pending = 0;
+          for (int* fd : {&slot.input_fd, &slot.output_fd})
+            if (*fd >= 0)
+              {
+                ring.close(*fd, tag(slot, CLOSE));
+                *fd = -1;
+                slot.pending++;
+              }
+          return;
+        }
+
+      files++;
+      if (slot.errorcode == NO_ERROR
+          && rename(slot.temporary_path.c_str(), slot.output_path.c_str()) != 0)
+        {
+          slot.errorcode = ERROR_READING_OR_WRITING_FILE;
+          slot.system_error = errno;
+        }
+      if (slot.errorcode != NO_ERROR)
+        {
+          failures++;
+          errorcode = slot.errorcode;
+          unlink(slot.temporary_path.c_str());
+
+          std::lock_guard<std::mutex> guard(report_lock);
+          std::cerr << slot.input_path << ": ";
+          if (slot.errorcode == INVALID_INPUT_CHARACTER)
+            {
+              std::cerr << slot.bad_letter;
+              cerr_tool(slot.errorcode);
+            }
+          else
+            std::cerr << "Error reading or writing file ("
+                      << std::strerror(slot.system_error) << ")\n";
+        }
+      start(slot);
+    };
+
+  auto fail = [&](BatchSlot& slot, int result)
+    {
+      if (slot.errorcode == NO_ERROR)
+        {
+          slot.errorcode = ERROR_READING_OR_WRITING_FILE;
+          slot.system_error = -result;
+        }
+    };
+
+  for (BatchSlot& slot : slots)
+    start(slot);
+
+  std::vector<IoCompletion> done;
+  while (true)
+    {
+      bool busy = false;
+      for (const BatchSlot& slot : slots)
+        busy = busy || slot.active;
+      if (!busy)
+        break;
+
+      if (ring.submit_and_wait(done) != NO_ERROR)
+        {
+          std::lock_guard<std::mutex> guard(report_lock);
+          std::cerr << "Error waiting for io_uring: " << std::strerror(errno)
+                    << "\n";
+          errorcode = ERROR_READING_OR_WRITING_FILE;
+          return;
+        }
+
+      for (const IoCompletion& completion : done)
+        {
+          BatchSlot& slot = slots[completion.tag >> OPERATION_BITS];
+          int result = completion.result;
+          int operation = completion.tag & ((1 << OPERATION_BITS) - 1);
+          switch (operation)
+            {
+            case OPEN_INPUT:
+            case OPEN_OUTPUT:
+              if (result < 0)
+                fail(slot, result);
+              else if (operation == OPEN_INPUT)
+                slot.input_fd = result;
+              else
+                slot.output_fd = result;
+              if (--slot.pending == 0)
+                {
+                  if (slot.errorcode != NO_ERROR)
+                    finish(slot);
+                  else
+                    read(slot);
+                }
+              break;
+
+            case READ:
+              {
+                if (result <= 0)
+                  {
+                    if (result < 0)
+                      fail(slot, result);
+                    finish(slot);
+                    break;
+                  }
+                bytes_read += result;
+                slot.input_offset += result;
+                std::unique_ptr<BlockEngine>& engine
+                  = engines[jobs[slot.job].key];
+                if (!engine)
+                  engine.reset(new BlockEngine(*slot.machine.wiring));
+                int length = encrypt_piece(*engine, slot.machine,
+                                           (char*) buffers[slot.index].iov_base,
+                                           result, slot.bad_letter);
+                if (length < 0)
+                  {
+                    slot.errorcode = INVALID_INPUT_CHARACTER;
+                    finish(slot);
+                  }
+                else if (length == 0)
+                  read(slot);
+                else
+                  {
+                    slot.length = length;
+                    slot.written = 0;
+                    write(slot);
+                  }
+                break;
+              }
+
+            case WRITE:
+              if (result <= 0)
+                {
+                  fail(slot, result < 0 ? result : -EIO);
+                  finish(slot);
+                  break;
+                }
+              bytes_written += result;
+              slot.written += result;
+              slot.output_offset += result;
+              if (slot.written < slot.length)
+                write(slot);
+              else
+                read(slot);
+              break;
+
+            case CLOSE:
+              if (result < 0)
+                fail(slot, result);
+              if (--slot.pending == 0)
+                finish(slot);
+              break;
+            }
+        }
+    }
+}
+
+int BatchEncryptor::run(int threads)
+{
+  std::vector<std::thread> workers;
+  for (int t = 0; t < threads; t++)
+    workers.emplace_back(&BatchEncryptor::worker, this);
+  for (std::thread& worker : workers)
+    worker.join();
+
+  return errorcode;
+}
+
+size_t BatchEncryptor::get_files() const
+{
+  return files;
+}
+
+size_t BatchEncryptor::get_failures() const
+{
+  return failures;
+}
+
+uint64_t BatchEncryptor::get_bytes_read() const
+{
+  return bytes_read;
+}
+
+uint64_t BatchEncryptor::get_bytes_written() const
+{
+  return bytes_written;
+}
+
+bool BatchEncryptor::is_native() const
+{
+  return native;
+}
@@ -0,0 +1,89 @@
+#ifndef BATCH_H
+#define BATCH_H
+#include <atomic>
+#include <cstdint>
+#include <mutex>
+#include <string>
+#include <vector>
+#include "machine.h"
+
+//size of each registered buffer, files are read and written in pieces of
+//at most this size
+int const BATCH_BUFFER_SIZE = 1 << 16;
+
+//file of a batch: its name in the input and output directories and the
+//index of the machine (key) it is encrypted with
+//the name is a plain file name, without / and other than . and .., so
+//that it stays inside both directories
+struct BatchJob {
+
+  std::string name;
+  int key;
+
+};
+
+//encryption of many files from an input directory into an output
+//directory, spread over worker threads
+//each thread owns an IoRing and a pool of registered buffers and keeps
+//depth files in flight: opens, reads, writes and closes are queued on the
+//ring and submitted together, and every file is encrypted piece by piece
+//as its reads complete
+//each output is written under its name with .tmp appended and renamed
+//when complete
+//letter machines skip whitespace and reject files with anything other than
+//A-Z (removing their output); 256-symbol machines encrypt every byte
+class BatchEncryptor {
+
+  std::string input_dir;
+  std::string output_dir;
+
+  std::vector<BatchJob> jobs;
+
+  //machines at their starting positions, indexed by BatchJob::key
+  std::vector<MachineState> keys;
+
+  //number of files each thread keeps in flight
+  int depth;
+
+  //next job to hand out
+  std::atomic<size_t> next_job{0};
+
+  //statistics
+  std::atomic<size_t> files{0};
+  std::atomic<size_t> failures{0};
+  std::atomic<uint64_t> bytes_read{0};
+  std::atomic<uint64_t> bytes_written{0};
+  std::atomic<bool> native{true};
+
+  //errorcode of the last failed file
+  std::atomic<int> errorcode{NO_ERROR};
+
+  //serialises messages to the error stream
+  std::mutex report_lock;
+
+  //function run by every worker thread
+  void worker();
+
+ public:
+
+  //keys[] holds the starting machines referred to by the jobs
+  BatchEncryptor(const std::string& input_dir, const std::string& output_dir,
+                 const std::vector<BatchJob>& jobs,
+                 const std::vector<MachineState>& keys, int depth);
+
+  //function to encrypt every file on threads worker threads
+  //returns errorcode (that of a failed file if any failed)
+  int run(int threads);
+
+  //getter functions for the statistics of the run
+  size_t get_files() const;
+  size_t get_failures() const;
+  uint64_t get_bytes_read() const;
+  uint64_t get_bytes_written() const;
+
+  //getter function for whether every thread used the kernel io_uring
+  bool is_native() const;
+
+};
+
+#endif
@@ -0,0 +1,218 @@
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+#include <deque>
+#include <dirent.h>
+#include <fstream>
+#include <iostream>
+#include <map>
+#include <sstream>
+#include <string>
+#include <sys/stat.h>
+#include <thread>
+#include <vector>
+#include "batch.h"
+#include "enigma.h"
+#include "errors.h"
+#include "machine.h"
+#include "tools.h"
+
+static int usage()
+{
+  std::cerr << "usage: batch [-t threads] [-q files-per-thread] input-dir"
+            << " output-dir (manifest-file | plugboard-file reflector-file"
+            << " (<rotor-file>)* rotor-positions)\n";
+  return INSUFFICIENT_NUMBER_OF_PARAMETERS;
+}
+
+//helper function to compile the machine given by configuration files (in
+//the order enigma takes them), once for every distinct configuration
+//key receives the index of the machine in keys
+//returns errorcode
+static int load_key(const std::vector<std::string>& files,
+                    std::map<std::vector<std::string>, int>& loaded,
+                    std::deque<Wiring>& wirings,
+                    std::vector<MachineState>& keys, int& key)
+{
+  auto found = loaded.find(files);
+  if (found != loaded.end())
+    {
+      key = found->second;
+      return NO_ERROR;
+    }
+
+  std::vector<std::string> arguments(files);
+  arguments.insert(arguments.begin(), "batch");
+  std::vector<char*> argv;
+  for (std::string& argument : arguments)
+    argv.push_back(&argument[0]);
+  argv.push_back(nullptr);
+
+  //the constructor reports configuration errors itself
+  Enigma enigma(arguments.size(), argv.data(), false);
+  if (enigma.get_enigma_error() != NO_ERROR)
+    return enigma.get_enigma_error();
+
+  wirings.emplace_back();
+  MachineState state;
+  int err = enigma.compile(wirings.back(), state);
+  if (err != NO_ERROR)
+    {
+      cerr_tool(err);
+      return err;
+    }
+
+  key = keys.size();
+  keys.push_back(state);
+  loaded[files] = key;
+  return NO_ERROR;
+}
+
+//helper function to list the regular files of a directory, sorted by name
+//returns errorcode
+static int list_directory(const std::string& path,
+                          std::vector<std::string>& names)
+{
+  DIR* directory = opendir(path.c_str());
+  if (directory == nullptr)
+    return ERROR_READING_OR_WRITING_FILE;
+
+  while (dirent* entry = readdir(directory))
+    {
+      bool regular = entry->d_type == DT_REG;
+      if (entry->d_type == DT_UNKNOWN)
+        {
+          struct stat status;
+          std::string file = path + "/" + entry->d_name;
+          regular = stat(file.c_str(), &status) == 0 && S_ISREG(status.st_mode);
+        }
+      if (regular)
+        names.push_back(entry->d_name);
+    }
+  closedir(directory);
+
+  std::sort(names.begin(), names.end());
+  return NO_ERROR;
+}
+
+int main(int argc, char** argv)
+{
+  //-t threads, -q files in flight per thread
+  long options[2] = {(long) std::thread::hardware_concurrency(), 16};
+
+  int err = take_options(argc, argv, "tq", options);
+  if (err != NO_ERROR)
+    {
+      cerr_tool(err);
+      return usage();
+    }
+  if (argc < 4 || argc == 5 || options[0] < 1 || options[1] < 1)
+    return usage();
+
+  std::string input_dir = argv[1];
+  std::string output_dir = argv[2];
+
+  std::deque<Wiring> wirings;
+  std::vector<MachineState> keys;
+  std::map<std::vector<std::string>, int> loaded;
+  std::vector<BatchJob> jobs;
+
+  if (argc == 4)
+    {
+      //manifest: one file per line, followed by its configuration files
+      std::ifstream manifest(argv[3]);
+      if (manifest.fail())
+        {
+          std::cerr << "Error opening manifest file " << argv[3] << "\n";
+          return ERROR_OPENING_CONFIGURATION_FILE;
+        }
+
+      std::string line;
+      for (int number = 1; std::getline(manifest, line); number++)
+        {
+          std::istringstream fields(line);
+          std::vector<std::string> files;
+          std::string name, file;
+          if (!(fields >> name))
+            continue;
+          while (fields >> file)
+            files.push_back(file);
+          if (name.find('/') != std::string::npos || name == "."
+              || name == "..")
+            {
+              std::cerr << "Invalid file name " << name << " on line "
+                        << number << " of manifest file " << argv[3]
+                        << " (files must be inside the input directory)\n";
+              return INVALID_INPUT_CHARACTER;
+            }
+          if (files.size() < 3)
+            {
+              std::cerr << "Insufficient number of configuration files for "
+                        << name << " on line " << number
+                        << " of manifest file " << argv[3] << "\n";
+              return INSUFFICIENT_NUMBER_OF_PARAMETERS;
+            }
+
+          int key;
+          err = load_key(files, loaded, wirings, keys, key);
+          if (err != NO_ERROR)
+            return err;
+          jobs.push_back({name, key});
+        }
+    }
+  else
+    {
+      //the same configuration for every file in the input directory
+      int key;
+      err = load_key(std::vector<std::string>(argv + 3, argv + argc), loaded,
+                     wirings, keys, key);
+      if (err != NO_ERROR)
+        return err;
+
+      std::vector<std::string> names;
+      if (list_directory(input_dir, names) != NO_ERROR)
+        {
+          std::cerr << "Error reading input directory " << input_dir << " ("
+                    << std::strerror(errno) << ")\n";
+          return ERROR_READING_OR_WRITING_FILE;
+        }
+      for (const std::string& name : names)
+        jobs.push_back({name, key});
+    }
+
+  if (mkdir(output_dir.c_str(), 0755) != 0 && errno != EEXIST)
+    {
+      std::cerr << "Error creating output directory " << output_dir << " ("
+                << std::strerror(errno) << ")\n";
+      return ERROR_READING_OR_WRITING_FILE;
+    }
+
+  //an output opened for writing in the input directory would truncate its
+  //input, however the two directories are named
+  struct stat input_status, output_status;
+  if (stat(input_dir.c_str(), &input_status) != 0
+      || stat(output_dir.c_str(), &output_status) != 0)
+    {
+      std::cerr << "Error reading directory " << input_dir << " or "
+                << output_dir << " (" << std::strerror(errno) << ")\n";
+      return ERROR_READING_OR_WRITING_FILE;
+    }
+  if (input_status.st_dev == output_status.st_dev
+      && input_status.st_ino == output_status.st_ino)
+    {
+      std::cerr << "Output directory " << output_dir << " is the input "
+                << "directory " << input_dir << "\n";
+      return INVALID_INDEX;
+    }
+
+  BatchEncryptor batch(input_dir, output_dir, jobs, keys, options[1]);
+  err = batch.run(options[0]);
+
+  std::cout << batch.get_files() - batch.get_failures() << " files encrypted ("
+            << batch.get_bytes_read() << " bytes read, "
+            << batch.get_bytes_written() << " bytes written, "
+            << batch.get_failures() << " failed) using "
+            << (batch.is_native() ? "io_uring" : "system calls") << "\n";
+
+  return err;
+}
@@ -0,0 +1,458 @@
+#include <algorithm>
+#include <chrono>
+#include <cerrno>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <map>
+#include <set>
+#include <sstream>
+#include <string>
+#include <unistd.h>
+#include <vector>
+#include "block.h"
+#include "enigma.h"
+#include "errors.h"
+#include "keycache.h"
+#include "keysearch.h"
+#include "keystream.h"
+#include "machine.h"
+#include "tools.h"
+
+//fixed workload matrix for the performance gate (make perfcheck)
+//every workload is timed runs times and reported in nanoseconds per
+//character (or per configuration parse) with its run-to-run spread
+//built with BYTE_ALPHABET (benchmark256) it measures the 256-symbol
+//machine from the files in bytes/, under names starting with byte/; the
+//search workloads score letter statistics and only run on letters
+
+//rotor library, the rotors of a machine are the first n of these
+#ifdef BYTE_ALPHABET
+static const char* rotor_files[] = {
+  "bytes/I.rot", "bytes/II.rot", "bytes/III.rot"
+};
+
+static const int rotor_counts[] = {0, 1, 3};
+
+static const char PLUGBOARD_FILE[] = "bytes/I.pb";
+static const char REFLECTOR_FILE[] = "bytes/I.rf";
+static const char WORKLOAD_PREFIX[] = "byte/";
+#else
+static const char* rotor_files[] = {
+  "rotors/I.rot", "rotors/II.rot", "rotors/III.rot", "rotors/IV.rot",
+  "rotors/V.rot", "rotors/VI.rot", "rotors/VII.rot", "rotors/VIII.rot"
+};
+
+static const int rotor_counts[] = {0, 1, 3, 5, 8};
+
+static const char PLUGBOARD_FILE[] = "plugboards/I.pb";
+static const char REFLECTOR_FILE[] = "reflectors/I.rf";
+static const char WORKLOAD_PREFIX[] = "";
+#endif
+
+static const int input_sizes[] = {1024, 65536, 1048576};
+
+//each timed run repeats its workload until it takes at least this long,
+//so that short workloads are not lost in timer and scheduler noise
+double const MIN_RUN_SECONDS = 0.05;
+
+//memory bound of the cache used by the cached workloads
+size_t const CACHE_BYTES = 64 << 20;
+
+//length of the message scored by the search workloads and most candidates
+//they try
+int const SEARCH_LENGTH = 128;
+uint64_t const SEARCH_CANDIDATES = 676;
+
+struct Measurement {
+  std::string name;
+  double mean;
+  double stddev;
+  double best;
+  int runs;
+};
+
+//helper class holding the command line of a machine with n rotors
+class MachineArguments {
+  std::vector<char*> argv;
+ public:
+  MachineArguments(int n_rotors)
+  {
+    argv.push_back((char*) "benchmark");
+    argv.push_back((char*) PLUGBOARD_FILE);
+    argv.push_back((char*) REFLECTOR_FILE);
+    for (int r = 0; r < n_rotors; r++)
+      argv.push_back((char*) rotor_files[r]);
+    argv.push_back((char*) "perf/positions.pos");
+  }
+  int argc() { return argv.size(); }
+  char** data() { return argv.data(); }
+};
+
+//helper function to time a workload
+//work(repeats) does the workload repeats times and returns the number of
+//items (characters or parses) it did
+template <typename Work>
+static Measurement measure(const std::string& name, int runs, Work work)
+{
+  //untimed calibration runs double the repeats until a run is long
+  //enough, which also warms up caches and the allocator
+  int repeats = 1;
+  for (;;)
+    {
+      auto start = std::chrono::steady_clock::now();
+      work(repeats);
+      std::chrono::duration<double> elapsed
+        = std::chrono::steady_clock::now() - start;
+      if (elapsed.count() >= MIN_RUN_SECONDS)
+        break;
+      repeats *= 2;
+    }
+
+  std::vector<double> samples;
+  for (int run = 0; run < runs; run++)
+    {
+      auto start = std::chrono::steady_clock::now();
+      long items = work(repeats);
+      auto stop = std::chrono::steady_clock::now();
+      samples.push_back(std::chrono::duration<double, std::nano>
+                        (stop - start).count() / items);
+    }
+
+  double sum = 0;
+  for (double sample : samples)
+    sum += sample;
+  double mean = sum / runs;
+
+  double squares = 0;
+  double best = samples[0];
+  for (double sample : samples)
+    {
+      squares += (sample - mean) * (sample - mean);
+      if (sample < best)
+        best = sample;
+    }
+  double stddev = runs > 1 ? std::sqrt(squares / (runs - 1)) : 0;
+
+  std::cerr << name << ": " << mean << " ns (+/- " << stddev << ")\n";
+  return Measurement{name, mean, stddev, best, runs};
+}
+
+//helper function to make a repeatable message of symbols of the alphabet
+static std::string make_message(int length)
+{
+  std::string message(length, FIRST_SYMBOL);
+  unsigned state = 12345;
+  for (char& letter : message)
+    {
+      state = state * 1103515245 + 12345;
+      letter = FIRST_SYMBOL + (state >> 16) % ALPHA_SIZE;
+    }
+  return message;
+}
+
+static std::string workload_name(const char mode[], int n_rotors, int size)
+{
+  return WORKLOAD_PREFIX + std::string(mode) + "/rotors="
+    + std::to_string(n_rotors) + "/size=" + std::to_string(size);
+}
+
+//returns errorcode
+static int run_matrix(int runs, std::vector<Measurement>& results)
+{
+  //configuration parsing from plugboards/, reflectors/ and rotors/ (or
+  //bytes/)
+  for (int n_rotors : rotor_counts)
+    {
+      MachineArguments arguments(n_rotors);
+      results.push_back(measure(WORKLOAD_PREFIX + std::string("parse/rotors=")
+                                + std::to_string(n_rotors),
+                                runs, [&](int repeats)
+        {
+          for (int i = 0; i < repeats; i++)
+            Enigma enigma(arguments.argc(), arguments.data(), false);
+          return (long) repeats;
+        }));
+    }
+
+  for (int size : input_sizes)
+    {
+      std::string message = make_message(size);
+
+      for (int n_rotors : rotor_counts)
+        {
+          MachineArguments arguments(n_rotors);
+
+          //classic machine: linked rotors driven through streams
+          results.push_back(measure(workload_name("classic", n_rotors, size),
+                                    runs, [&](int repeats)
+            {
+              Enigma enigma(arguments.argc(), arguments.data(), false);
+              for (int i = 0; i < repeats; i++)
+                {
+                  std::istringstream in(message);
+                  std::ostringstream out;
+                  enigma.encrypt_message(in, out);
+                }
+              return (long) repeats * size;
+            }));
+
+          //compact machine: shared wiring and a MachineState
+          Enigma enigma(arguments.argc(), arguments.data(), false);
+          Wiring wiring;
+          MachineState start;
+          enigma.compile(wiring, start);
+          std::string output(message);
+
+          results.push_back(measure(workload_name("compact", n_rotors, size),
+                                    runs, [&](int repeats)
+            {
+              MachineState machine = start;
+              for (int i = 0; i < repeats; i++)
+                machine.encrypt((const symbol*) message.data(),
+                                (symbol*) &output[0], size);
+              return (long) repeats * size;
+            }));
+
+          //compact machine through the single-stream block engine
+          BlockEngine engine(wiring);
+          results.push_back(measure(workload_name("block", n_rotors, size),
+                                    runs, [&](int repeats)
+            {
+              MachineState machine = start;
+              for (int i = 0; i < repeats; i++)
+                engine.encrypt(machine, (const symbol*) message.data(),
+                               (symbol*) &output[0], size);
+              return (long) repeats * size;
+            }));
+
+          //compact machine through a KeystreamCache, warmed by the
+          //calibration run so that it measures repeated traffic
+          KeystreamCache cache(CACHE_BYTES);
+          results.push_back(measure(workload_name("cached", n_rotors, size),
+                                    runs, [&](int repeats)
+            {
+              for (int i = 0; i < repeats; i++)
+                {
+                  MachineState machine = start;
+                  cache.encrypt(machine, (const symbol*) message.data(),
+                                (symbol*) &output[0], size);
+                }
+              return (long) repeats * size;
+            }));
+
+          //message read off an exported keystream file
+          char path[] = "/tmp/benchmark-keystream-XXXXXX";
+          int fd = mkstemp(path);
+          if (fd < 0)
+            {
+              std::cerr << "Error creating keystream file " << path << " ("
+                        << std::strerror(errno) << ")\n";
+              return ERROR_READING_OR_WRITING_FILE;
+            }
+          close(fd);
+          write_keystream(path, start, size);
+          Keystream keystream(path);
+          unlink(path);
+          results.push_back(measure(workload_name("keystream", n_rotors, size),
+                                    runs, [&](int repeats)
+            {
+              for (int i = 0; i < repeats; i++)
+                keystream.encrypt(0, (const symbol*) message.data(),
+                                  (symbol*) &output[0], size);
+              return (long) repeats * size;
+            }));
+        }
+    }
+
+#ifndef BYTE_ALPHABET
+  //key search over the starting positions of one rotor order, scoring a
+  //message under each: every candidate set up afresh, and the candidates
+  //walked in Gray code order through a BlockEngine
+  std::string message = make_message(SEARCH_LENGTH);
+  std::vector<uint8_t> cipher;
+  for (char letter : message)
+    cipher.push_back(letter - 'A');
+  std::string plain(message);
+
+  for (int n_rotors : rotor_counts)
+    {
+      MachineArguments arguments(n_rotors);
+      Enigma enigma(arguments.argc(), arguments.data(), false);
+      Wiring wiring;
+      MachineState start;
+      enigma.compile(wiring, start);
+      KeySpace space(1, n_rotors, n_rotors);
+      uint64_t candidates = std::min(space.positions(), SEARCH_CANDIDATES);
+
+      results.push_back(measure(workload_name("search", n_rotors,
+                                              SEARCH_LENGTH),
+                                runs, [&](int repeats)
+        {
+          int reflector;
+          int order[MAX_ROTORS];
+          int positions[MAX_ROTORS];
+          for (int i = 0; i < repeats; i++)
+            for (uint64_t id = 0; id < candidates; id++)
+              {
+                space.decode(id, reflector, order, positions);
+                start.start(positions);
+                score_decryption(start, cipher.data(), SEARCH_LENGTH);
+              }
+          return (long) repeats * candidates * SEARCH_LENGTH;
+        }));
+
+      BlockEngine engine(wiring);
+      results.push_back(measure(workload_name("graysearch", n_rotors,
+                                              SEARCH_LENGTH),
+                                runs, [&](int repeats)
+        {
+          for (int i = 0; i < repeats; i++)
+            {
+              GrayWalk walk(wiring);
+              for (uint64_t id = 0; id < candidates; id++, walk.next())
+                score_decryption(engine, walk.get_machine(),
+                                 (const symbol*) message.data(),
+                                 (symbol*) &plain[0], SEARCH_LENGTH);
+            }
+          return (long) repeats * candidates * SEARCH_LENGTH;
+        }));
+    }
+#endif
+
+  return NO_ERROR;
+}
+
+static void write_json(std::ostream& out, const std::vector<Measurement>& results)
+{
+  out << "{\n  \"unit\": \"ns\",\n  \"results\": [\n";
+  for (size_t i = 0; i < results.size(); i++)
+    {
+      char line[256];
+      std::snprintf(line, sizeof(line), "    {\"name\": \"%s\", \"mean\": "
+                    "%.3f, \"stddev\": %.3f, \"best\": %.3f, \"runs\": %d}%s\n",
+                    results[i].name.c_str(), results[i].mean,
+                    results[i].stddev, results[i].best, results[i].runs,
+                    i + 1 < results.size() ? "," : "");
+      out << line;
+    }
+  out << "  ]\n}\n";
+}
+
+//helper function to read the name, mean and spread of every result of a
+//file written by write_json
+static bool read_json(const char path[],
+                      std::map<std::string, Measurement>& results)
+{
+  std::ifstream in(path);
+  if (in.fail())
+    return false;
+
+  std::string line;
+  while (std::getline(in, line))
+    {
+      size_t name = line.find("\"name\": \"");
+      size_t mean = line.find("\"mean\": ");
+      size_t stddev = line.find("\"stddev\": ");
+      size_t best = line.find("\"best\": ");
+      size_t runs = line.find("\"runs\": ");
+      if (name == std::string::npos || mean == std::string::npos
+          || stddev == std::string::npos || best == std::string::npos
+          || runs == std::string::npos)
+        continue;
+      name += 9;
+      Measurement result;
+      result.name = line.substr(name, line.find('"', name) - name);
+      result.mean = std::stod(line.substr(mean + 8));
+      result.stddev = std::stod(line.substr(stddev + 10));
+      result.best = std::stod(line.substr(best + 8));
+      result.runs = std::stoi(line.substr(runs + 8));
+      results[result.name] = result;
+    }
+  return true;
+}
+
+int main(int argc, char** argv)
+{
+  //-r runs per workload, -t allowed slowdown in percent
+  long options[2] = {5, 30};
+
+  int err = take_options(argc, argv, "rt", options);
+  if (err != NO_ERROR || argc < 2 || argc > 3 || options[0] < 1)
+    {
+      cerr_tool(err);
+      std::cerr << "usage: benchmark [-r runs] [-t threshold-percent] "
+                << "results.json [baseline.json]\n";
+      return err != NO_ERROR ? err : INSUFFICIENT_NUMBER_OF_PARAMETERS;
+    }
+
+  std::vector<Measurement> results;
+  err = run_matrix(options[0], results);
+  if (err != NO_ERROR)
+    return err;
+
+  std::ofstream out(argv[1]);
+  if (out.fail())
+    {
+      std::cerr << "Error opening results file " << argv[1] << "\n";
+      return ERROR_OPENING_CONFIGURATION_FILE;
+    }
+  write_json(out, results);
+  out.close();
+
+  if (argc < 3)
+    return NO_ERROR;
+
+  std::map<std::string, Measurement> baseline;
+  if (!read_json(argv[2], baseline))
+    {
+      std::cerr << "Error opening baseline file " << argv[2] << "\n";
+      return ERROR_OPENING_CONFIGURATION_FILE;
+    }
+
+  //a workload regresses when its fastest run is slower than the fastest
+  //baseline run by more than the threshold; the fastest run is the one
+  //least disturbed by anything else running on the machine
+  int regressions = 0;
+  std::set<std::string> measured;
+  for (const Measurement& result : results)
+    {
+      measured.insert(result.name);
+      auto found = baseline.find(result.name);
+      if (found == baseline.end())
+        {
+          std::cerr << "new       " << result.name << "\n";
+          continue;
+        }
+      const Measurement& base = found->second;
+      double change = 100 * (result.best / base.best - 1);
+      bool regressed = change > options[1];
+      if (regressed)
+        regressions++;
+      char line[256];
+      std::snprintf(line, sizeof(line), "%-9s %-32s %+7.1f%%\n",
+                    regressed ? "REGRESSED" : "ok", result.name.c_str(),
+                    change);
+      std::cerr << line;
+    }
+
+  //a workload that is no longer run cannot show that it has not regressed
+  for (const auto& base : baseline)
+    if (measured.count(base.first) == 0)
+      {
+        std::cerr << "MISSING   " << base.first << "\n";
+        regressions++;
+      }
+
+  if (regressions > 0)
+    {
+      std::cerr << regressions << " workloads regressed by more than "
+                << options[1] << "% or are missing\n";
+      return PERFORMANCE_REGRESSION;
+    }
+
+  return NO_ERROR;
+}
@@ -0,0 +1,52 @@
+#include "binaryio.h"
+
+void write_value(std::ostream& out, uint64_t value)
+{
+  out.write((const char*) &value, sizeof(value));
+}
+
+uint64_t read_value(std::istream& in)
+{
+  uint64_t value = 0;
+  in.read((char*) &value, sizeof(value));
+  return value;
+}
+
+uint64_t read_count(std::istream& in, uint64_t limit)
+{
+  uint64_t count = read_value(in);
+  if (count > limit)
+    in.setstate(std::ios::failbit);
+  return in.good() ? count : 0;
+}
+
+void write_name(std::ostream& out, const std::string& name)
+{
+  write_value(out, name.size());
+  out.write(name.data(), name.size());
+}
+
+void read_name(std::istream& in, std::string& name)
+{
+  uint64_t length = read_count(in, MAX_NAME_LENGTH);
+  name.assign(length, '\0');
+  in.read(&name[0], length);
+}
+
+void write_names(std::ostream& out, const std::vector<std::string>& names)
+{
+  write_value(out, names.size());
+  for (const std::string& name : names)
+    write_name(out, name);
+}
+
+void read_names(std::istream& in, std::vector<std::string>& names)
+{
+  uint64_t count = read_count(in, MAX_NAMES);
+  names.clear();
+  for (uint64_t i = 0; i < count && in.good(); i++)
+    {
+      names.emplace_back();
+      read_name(in, names.back());
+    }
+}
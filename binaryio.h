@@ -0,0 +1,51 @@
+#ifndef BINARYIO_H
+#define BINARYIO_H
+#include <cstdint>
+#include <iostream>
+#include <string>
+#include <vector>
+
+//helper functions to write and read the binary files of the tools (crib
+//indexes and catalogs)
+//values are stored as 8 bytes in the byte order of the machine, and names
+//and arrays after their length
+//a reader that meets a damaged file sets failbit on the stream rather than
+//allocating without bound or returning part of what the file holds
+
+//longest name, most names in a list and most elements in an array a
+//reader accepts
+uint64_t const MAX_NAME_LENGTH = 4096;
+uint64_t const MAX_NAMES = 1 << 16;
+uint64_t const MAX_ARRAY_LENGTH = (uint64_t) 1 << 34;
+
+void write_value(std::ostream& out, uint64_t value);
+uint64_t read_value(std::istream& in);
+
+//function to read a count, failing the stream if it is above limit
+uint64_t read_count(std::istream& in, uint64_t limit);
+
+void write_name(std::ostream& out, const std::string& name);
+void read_name(std::istream& in, std::string& name);
+
+void write_names(std::ostream& out, const std::vector<std::string>& names);
+void read_names(std::istream& in, std::vector<std::string>& names);
+
+template <typename T>
+void write_array(std::ostream& out, const std::vector<T>& values)
+{
+  write_value(out, values.size());
+  out.write((const char*) values.data(), values.size() * sizeof(T));
+}
+
+template <typename T>
+void read_array(std::istream& in, std::vector<T>& values)
+{
+  uint64_t count = read_count(in, MAX_ARRAY_LENGTH);
+  values.clear();
+  if (!in.good())
+    return;
+  values.resize(count);
+  in.read((char*) values.data(), count * sizeof(T));
+}
+
+#endif
@@ -0,0 +1,222 @@
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+#include <immintrin.h>
+#include "block.h"
+
+//helper functions to move a letter by a rotor position
+static inline int add(int letter, int position)
+{
+  letter += position;
+  return letter >= ALPHA_SIZE ? letter - ALPHA_SIZE : letter;
+}
+
+static inline int subtract(int letter, int position)
+{
+  letter -= position;
+  return letter < 0 ? letter + ALPHA_SIZE : letter;
+}
+
+//helper function to encrypt a run of letters one at a time
+//pb[], fw[] and bw[] are the plugboard and the rightmost rotor at position
+//0, core[] is the rest of the machine and the letter at i is typed with
+//the rightmost rotor at position + i
+static void run_scalar(const uint8_t pb[], const uint8_t fw[],
+                       const uint8_t bw[], const uint8_t core[], int position,
+                       const symbol in[], symbol out[], size_t length)
+{
+  for (size_t i = 0; i < length; i++)
+    {
+      int letter = pb[in[i] - FIRST_SYMBOL];
+      letter = subtract(fw[add(letter, position)], position);
+      letter = core[letter];
+      letter = subtract(bw[add(letter, position)], position);
+      out[i] = pb[letter] + FIRST_SYMBOL;
+      position = add(position, 1);
+    }
+}
+
+#ifndef BYTE_ALPHABET
+
+//helper function to look up 32 letters in a table of 26 letters held in
+//two 16-byte halves (each broadcast to both lanes)
+__attribute__((target("avx2")))
+static inline __m256i lookup(__m256i low, __m256i high, __m256i index)
+{
+  __m256i sixteen = _mm256_set1_epi8(16);
+  __m256i from_low = _mm256_shuffle_epi8(low, index);
+  __m256i from_high = _mm256_shuffle_epi8(high,
+                                          _mm256_sub_epi8(index, sixteen));
+  return _mm256_blendv_epi8(from_high, from_low,
+                            _mm256_cmpgt_epi8(sixteen, index));
+}
+
+//helper function to bring letters in [0, 52) back into [0, 26)
+__attribute__((target("avx2")))
+static inline __m256i reduce(__m256i letters)
+{
+  return _mm256_min_epu8(letters,
+                         _mm256_sub_epi8(letters, _mm256_set1_epi8(ALPHA_SIZE)));
+}
+
+//helper function to load a table of 26 letters as its two halves
+__attribute__((target("avx2")))
+static inline void load_table(const uint8_t table[], __m256i& low,
+                              __m256i& high)
+{
+  uint8_t padded[32] = {0};
+  std::memcpy(padded, table, ALPHA_SIZE);
+  low = _mm256_broadcastsi128_si256(_mm_loadu_si128((const __m128i*) padded));
+  high = _mm256_broadcastsi128_si256(
+    _mm_loadu_si128((const __m128i*) (padded + 16)));
+}
+
+//shortest run worth padding to 32 letters for the vector path
+size_t const MIN_VECTOR_RUN = 8;
+
+//helper function to encrypt a run of letters 32 at a time, as run_scalar
+//a run shorter than 32 letters (or the end of a longer one) is padded
+__attribute__((target("avx2")))
+static void run_avx2(const uint8_t pb[], const uint8_t fw[],
+                     const uint8_t bw[], const uint8_t core[], int position,
+                     const symbol in[], symbol out[], size_t length)
+{
+  __m256i pb_low, pb_high, fw_low, fw_high, bw_low, bw_high;
+  __m256i core_low, core_high;
+  load_table(pb, pb_low, pb_high);
+  load_table(fw, fw_low, fw_high);
+  load_table(bw, bw_low, bw_high);
+  load_table(core, core_low, core_high);
+
+  __m256i first = _mm256_set1_epi8(FIRST_SYMBOL);
+  __m256i n = _mm256_set1_epi8(ALPHA_SIZE);
+  __m256i steps = _mm256_setr_epi8(0, 1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11, 12,
+                                   13, 14, 15, 16, 17, 18, 19, 20, 21, 22,
+                                   23, 24, 25, 0, 1, 2, 3, 4, 5);
+
+  symbol padded[32];
+  for (size_t i = 0; i < length; i += 32)
+    {
+      const symbol* from = in + i;
+      symbol* to = out + i;
+      if (length - i < 32)
+        {
+          std::memset(padded, FIRST_SYMBOL, sizeof(padded));
+          std::memcpy(padded, from, length - i);
+          from = to = padded;
+        }
+
+      //positions of the rightmost rotor for the 32 letters
+      __m256i p = reduce(_mm256_add_epi8(_mm256_set1_epi8(position), steps));
+      __m256i back = _mm256_sub_epi8(n, p);
+
+      __m256i letters = _mm256_sub_epi8(
+        _mm256_loadu_si256((const __m256i*) from), first);
+      letters = lookup(pb_low, pb_high, letters);
+      letters = lookup(fw_low, fw_high, reduce(_mm256_add_epi8(letters, p)));
+      letters = lookup(core_low, core_high,
+                       reduce(_mm256_add_epi8(letters, back)));
+      letters = lookup(bw_low, bw_high, reduce(_mm256_add_epi8(letters, p)));
+      letters = lookup(pb_low, pb_high,
+                       reduce(_mm256_add_epi8(letters, back)));
+      _mm256_storeu_si256((__m256i*) to, _mm256_add_epi8(letters, first));
+      if (to == padded)
+        std::memcpy(out + i, padded, length - i);
+
+      //32 steps on is 6 positions on
+      position = add(position, 32 - ALPHA_SIZE);
+    }
+}
+
+#endif
+
+BlockEngine::BlockEngine(const Wiring& wiring)
+  : wiring(&wiring)
+{
+#ifdef BYTE_ALPHABET
+  vectorized = false;
+#else
+  vectorized = __builtin_cpu_supports("avx2");
+#endif
+
+  //without notches the rightmost rotor never turns the others, a run is
+  //then only limited by the message
+  int right = wiring.n_rotors - 1;
+  for (int p = MIN_INDEX; p <= MAX_INDEX; p++)
+    {
+      to_notch[p] = SIZE_MAX;
+      if (right < 1)
+        continue;
+      for (int k = 1; k <= ALPHA_SIZE; k++)
+        if (wiring.notch[right][(p + k) % ALPHA_SIZE])
+          {
+            to_notch[p] = k;
+            break;
+          }
+    }
+}
+
+const uint8_t* BlockEngine::core(const MachineState& state)
+{
+  const Wiring& w = *wiring;
+  int levels = w.n_rotors - 1;
+  if (levels == 0)
+    return w.reflector;
+
+  //levels from the first rotor that moved on are out of date
+  int k = 0;
+  while (k < valid && core_position[k] == state.position[k])
+    k++;
+
+  for (; k < levels; k++)
+    {
+      int p = state.position[k];
+      const uint8_t* inner = k == 0 ? w.reflector : cores[k - 1];
+      for (int i = MIN_INDEX; i <= MAX_INDEX; i++)
+        cores[k][i] = w.bw_at[k][p][inner[w.fw_at[k][p][i]]];
+      core_position[k] = p;
+    }
+  valid = levels;
+
+  return cores[levels - 1];
+}
+
+void BlockEngine::encrypt(MachineState& state, const symbol in[],
+                          symbol out[], size_t length)
+{
+  const Wiring& w = *wiring;
+  if (w.n_rotors == 0)
+    {
+      state.encrypt(in, out, length);
+      return;
+    }
+
+  int right = w.n_rotors - 1;
+  size_t done = 0;
+  while (done < length)
+    {
+      //the first letter of a run may turn the other rotors, the rest of
+      //the run up to the next notch only turns the rightmost rotor
+      state.keypress();
+      int position = state.position[right];
+      size_t run = std::min(to_notch[position], length - done);
+
+      const uint8_t* rest = core(state);
+#ifndef BYTE_ALPHABET
+      if (vectorized && run >= MIN_VECTOR_RUN)
+        run_avx2(w.plugboard, w.fw[right], w.bw[right], rest, position,
+                 in + done, out + done, run);
+      else
+#endif
+        run_scalar(w.plugboard, w.fw[right], w.bw[right], rest, position,
+                   in + done, out + done, run);
+
+      state.position[right] = (position + run - 1) % ALPHA_SIZE;
+      done += run;
+    }
+}
+
+bool BlockEngine::is_vectorized() const
+{
+  return vectorized;
+}
@@ -0,0 +1,58 @@
+#ifndef BLOCK_H
+#define BLOCK_H
+#include <cstddef>
+#include <cstdint>
+#include "machine.h"
+
+//single-stream engine encrypting runs of consecutive letters at once
+//between two notches of the rightmost rotor the other rotors stand still,
+//so everything left of the rightmost rotor is one fixed permutation (the
+//core) for the whole run; with p the position of the rightmost rotor at a
+//step, the letter at that step goes through
+//  plugboard, +p, rightmost rotor, -p, core, +p, rightmost rotor back, -p,
+//  plugboard
+//where every table is the same for the whole run and only p changes from
+//letter to letter; on CPUs with AVX2 32 letters are sent through these
+//tables together with byte shuffles, elsewhere (and for the 256-symbol
+//machine) one at a time
+//the cores are cached level by level, so a change of the rotor next to
+//the rightmost one only recomputes the outermost level
+//an engine caches the cores of one Wiring and belongs to one thread
+class BlockEngine {
+
+  const Wiring* wiring;
+
+  //cores[k] is rotors 0-k around the reflector at positions core_position
+  //(levels 0 to valid - 1 are up to date)
+  uint8_t cores[MAX_ROTORS][ALPHA_SIZE];
+  uint8_t core_position[MAX_ROTORS];
+  int valid = 0;
+
+  //to_notch[p] is the number of steps from position p of the rightmost
+  //rotor to the next step at which it turns its left neighbour
+  size_t to_notch[ALPHA_SIZE];
+
+  //true if the CPU supports the vector path
+  bool vectorized;
+
+  //helper function to get the core for the positions of a machine
+  const uint8_t* core(const MachineState& state);
+
+ public:
+
+  //wiring is the machine the engine is used with, it must outlive the
+  //engine
+  BlockEngine(const Wiring& wiring);
+
+  //function to encrypt a run of symbols, leaving the machine where
+  //MachineState::encrypt would
+  //in and out may be the same buffer
+  void encrypt(MachineState& state, const symbol in[], symbol out[],
+               size_t length);
+
+  //getter function for whether the vector path is used
+  bool is_vectorized() const;
+
+};
+
+#endif
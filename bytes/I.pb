@@ -0,0 +1,2 @@
+43 49 180 239 143 89 96 18 99 225 160 27 2 108 60 32
+44 104 132 198
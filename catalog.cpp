@@ -0,0 +1,262 @@
+#include <algorithm>
+#include <atomic>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <functional>
+#include <numeric>
+#include <thread>
+#include "binaryio.h"
+#include "catalog.h"
+#include "errors.h"
+
+//number of candidates a thread takes at a time while building a catalog
+uint64_t const CATALOG_CHUNK = 4096;
+
+//helper function to find the cycle lengths of a permutation, longest first
+static void cycle_lengths(const uint8_t perm[], std::vector<int>& lengths)
+{
+  bool seen[ALPHA_SIZE] = {false};
+  lengths.clear();
+  for (int i = MIN_INDEX; i <= MAX_INDEX; i++)
+    {
+      int length = 0;
+      for (int j = i; !seen[j]; j = perm[j])
+        {
+          seen[j] = true;
+          length++;
+        }
+      if (length > 0)
+        lengths.push_back(length);
+    }
+  std::sort(lengths.begin(), lengths.end(), std::greater<int>());
+}
+
+uint64_t Characteristic::signature() const
+{
+  //64-bit FNV-1a over the distance and the cycle lengths, with a 0 after
+  //each product
+  uint64_t hash = 14695981039346656037ULL;
+  auto mix = [&hash](int value)
+    {
+      hash ^= value;
+      hash *= 1099511628211ULL;
+    };
+  mix(distance);
+  for (int i = 0; i < distance; i++)
+    {
+      for (int length : cycles[i])
+        mix(length);
+      mix(0);
+    }
+  return hash;
+}
+
+std::string Characteristic::describe() const
+{
+  std::string text;
+  for (int i = 0; i < distance; i++)
+    {
+      if (i > 0)
+        text += " |";
+      for (int length : cycles[i])
+        text += " " + std::to_string(length);
+    }
+  return text.empty() ? text : text.substr(1);
+}
+
+void machine_characteristic(MachineState machine, int distance,
+                            Characteristic& characteristic)
+{
+  uint8_t perms[2 * MAX_DISTANCE][ALPHA_SIZE];
+  for (int t = 0; t < 2 * distance; t++)
+    {
+      machine.keypress();
+      machine.permutation(perms[t]);
+    }
+
+  characteristic.distance = distance;
+  uint8_t product[ALPHA_SIZE];
+  for (int i = 0; i < distance; i++)
+    {
+      for (int x = MIN_INDEX; x <= MAX_INDEX; x++)
+        product[x] = perms[i + distance][perms[i][x]];
+      cycle_lengths(product, characteristic.cycles[i]);
+    }
+}
+
+int indicator_characteristic(const std::vector<std::vector<uint8_t>>& indicators,
+                             int distance, Characteristic& characteristic)
+{
+  characteristic.distance = distance;
+  for (int i = 0; i < distance; i++)
+    {
+      //every letter at step i + 1 of an indicator is followed distance
+      //steps later by its image under the product
+      uint8_t product[ALPHA_SIZE];
+      bool known[ALPHA_SIZE] = {false};
+      bool image[ALPHA_SIZE] = {false};
+      int n_known = 0;
+      for (const std::vector<uint8_t>& indicator : indicators)
+        {
+          uint8_t from = indicator[i];
+          uint8_t to = indicator[i + distance];
+          if (known[from])
+            {
+              if (product[from] != to)
+                return INVALID_INDEX;
+              continue;
+            }
+          if (image[to])
+            return INVALID_INDEX;
+          product[from] = to;
+          known[from] = image[to] = true;
+          n_known++;
+        }
+      if (n_known < ALPHA_SIZE)
+        return INSUFFICIENT_NUMBER_OF_PARAMETERS;
+      cycle_lengths(product, characteristic.cycles[i]);
+    }
+  return NO_ERROR;
+}
+
+KeySpace Catalog::space() const
+{
+  return KeySpace(reflectors.size(), rotors.size(), n_rotors);
+}
+
+int Catalog::build(const Plugboard& plugboard,
+                   const std::vector<const Reflector*>& reflector_library,
+                   const std::vector<const RotorWiring*>& rotor_library,
+                   int threads)
+{
+  KeySpace keys(reflector_library.size(), rotor_library.size(), n_rotors);
+  uint64_t size = keys.size();
+  if (size >= ((uint64_t) 1 << 32))
+    return INVALID_INDEX;
+
+  //signature of every candidate, computed in chunks handed out to threads
+  std::vector<uint64_t> keyed(size);
+  std::atomic<uint64_t> next_chunk{0};
+
+  auto work = [&]()
+    {
+      KeyLoader loader(keys, plugboard, reflector_library, rotor_library);
+      Characteristic characteristic;
+
+      for (uint64_t begin = next_chunk++ * CATALOG_CHUNK; begin < size;
+           begin = next_chunk++ * CATALOG_CHUNK)
+        for (uint64_t id = begin; id < std::min(size, begin + CATALOG_CHUNK);
+             id++)
+          {
+            loader.load(id);
+            machine_characteristic(loader.get_machine(), distance,
+                                   characteristic);
+            keyed[id] = characteristic.signature();
+          }
+    };
+
+  std::vector<std::thread> workers;
+  for (int t = 0; t < threads; t++)
+    workers.emplace_back(work);
+  for (std::thread& worker : workers)
+    worker.join();
+
+  //group the candidates by signature
+  std::vector<uint32_t> sorted(size);
+  std::iota(sorted.begin(), sorted.end(), 0);
+  std::sort(sorted.begin(), sorted.end(), [&keyed](uint32_t a, uint32_t b)
+    {
+      return keyed[a] != keyed[b] ? keyed[a] < keyed[b] : a < b;
+    });
+
+  signatures.clear();
+  starts.clear();
+  ids = sorted;
+  for (uint32_t i = 0; i < size; i++)
+    if (i == 0 || keyed[sorted[i]] != keyed[sorted[i - 1]])
+      {
+        signatures.push_back(keyed[sorted[i]]);
+        starts.push_back(i);
+      }
+  starts.push_back(size);
+
+  return NO_ERROR;
+}
+
+std::vector<uint32_t> Catalog::lookup(uint64_t signature) const
+{
+  auto found = std::lower_bound(signatures.begin(), signatures.end(),
+                                signature);
+  if (found == signatures.end() || *found != signature)
+    return std::vector<uint32_t>();
+
+  size_t index = found - signatures.begin();
+  return std::vector<uint32_t>(ids.begin() + starts[index],
+                               ids.begin() + starts[index + 1]);
+}
+
+int Catalog::write(const std::string& path) const
+{
+  std::string temporary = path + ".tmp";
+  std::ofstream out(temporary, std::ios::binary);
+  if (out.fail())
+    return ERROR_OPENING_CONFIGURATION_FILE;
+
+  out.write(CATALOG_MAGIC, std::strlen(CATALOG_MAGIC));
+  write_value(out, distance);
+  write_value(out, n_rotors);
+  write_names(out, reflectors);
+  write_names(out, rotors);
+  write_array(out, signatures);
+  write_array(out, starts);
+  write_array(out, ids);
+
+  out.close();
+  if (out.fail())
+    return ERROR_OPENING_CONFIGURATION_FILE;
+
+  //rename is atomic, so readers see either the old or the new catalog
+  if (std::rename(temporary.c_str(), path.c_str()) != 0)
+    return ERROR_OPENING_CONFIGURATION_FILE;
+
+  return NO_ERROR;
+}
+
+int Catalog::read(const std::string& path)
+{
+  std::ifstream in(path, std::ios::binary);
+  if (in.fail())
+    return ERROR_OPENING_CONFIGURATION_FILE;
+
+  char magic[sizeof(CATALOG_MAGIC)] = {0};
+  in.read(magic, std::strlen(CATALOG_MAGIC));
+  if (std::strcmp(magic, CATALOG_MAGIC) != 0)
+    return NON_NUMERIC_CHARACTER;
+
+  distance = read_value(in);
+  n_rotors = read_value(in);
+  read_names(in, reflectors);
+  read_names(in, rotors);
+  read_array(in, signatures);
+  read_array(in, starts);
+  read_array(in, ids);
+
+  if (in.fail() || distance < 1 || distance > MAX_DISTANCE || n_rotors < 0
+      || n_rotors > MAX_ROTORS || starts.size() != signatures.size() + 1
+      || starts.back() != ids.size())
+    return NON_NUMERIC_CHARACTER;
+
+  for (size_t i = 1; i < starts.size(); i++)
+    if (starts[i] < starts[i - 1])
+      return NON_NUMERIC_CHARACTER;
+
+  //every id must lie in the key space of the catalog, so that lookup never
+  //hands out a candidate that cannot be decoded
+  uint64_t size = space().size();
+  if (std::any_of(ids.begin(), ids.end(),
+                  [size](uint32_t id) { return id >= size; }))
+    return NON_NUMERIC_CHARACTER;
+
+  return NO_ERROR;
+}
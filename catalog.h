@@ -0,0 +1,92 @@
+#ifndef CATALOG_H
+#define CATALOG_H
+#include <cstdint>
+#include <string>
+#include <vector>
+#include "keysearch.h"
+#include "machine.h"
+
+//magic string at the start of a catalog file
+#define CATALOG_MAGIC "ENCATLG1"
+
+//largest distance between the permutations of a characteristic
+int const MAX_DISTANCE = 8;
+
+//cycle structure of the products of the permutations the machine applies
+//distance steps apart (Rejewski's characteristic of a day for distance 3)
+//product i maps the letter at step i + 1 to the letter at step
+//i + 1 + distance, and the plugboard only conjugates it, so the cycle
+//structure depends on the reflector, rotor order and positions alone
+struct Characteristic {
+
+  int distance;
+
+  //cycle lengths of each product, longest first
+  std::vector<int> cycles[MAX_DISTANCE];
+
+  //function to hash the cycle structure into a catalog key
+  uint64_t signature() const;
+
+  //function to describe the cycle structure, e.g. "13 13 | 10 10 3 3 | ..."
+  std::string describe() const;
+
+};
+
+//function to compute the characteristic of a machine from its positions
+//machine is copied and stepped 2 * distance times
+void machine_characteristic(MachineState machine, int distance,
+                            Characteristic& characteristic);
+
+//function to compute the characteristic from indicators, each holding
+//2 * distance letters as indexes 0-25
+//returns errorcode (INSUFFICIENT_NUMBER_OF_PARAMETERS if the indicators
+//leave a product incomplete, INVALID_INDEX if they contradict each other)
+int indicator_characteristic(const std::vector<std::vector<uint8_t>>& indicators,
+                             int distance, Characteristic& characteristic);
+
+//catalog of the characteristics of every reflector, rotor order and
+//starting position of a KeySpace, indexed by signature
+//on disk the catalog holds its parameters and file names followed by the
+//distinct signatures in increasing order, the start of the candidates of
+//each signature and the candidate ids grouped by signature
+struct Catalog {
+
+  int distance;
+  int n_rotors;
+
+  std::vector<std::string> reflectors;
+  std::vector<std::string> rotors;
+
+  std::vector<uint64_t> signatures;
+  std::vector<uint32_t> starts;
+  std::vector<uint32_t> ids;
+
+  //function to compute the catalog on threads threads, for the distance
+  //and n_rotors set beforehand
+  //reflectors and rotors hold the components of the KeySpace, plugboard
+  //is any plugboard (it does not change a characteristic)
+  //returns errorcode (INVALID_INDEX if the space has 2^32 candidates or more)
+  int build(const Plugboard& plugboard,
+            const std::vector<const Reflector*>& reflector_library,
+            const std::vector<const RotorWiring*>& rotor_library,
+            int threads);
+
+  //function to get the key space the candidate ids refer to
+  KeySpace space() const;
+
+  //function to find the candidates with a signature
+  //returns the candidate ids, in increasing order
+  std::vector<uint32_t> lookup(uint64_t signature) const;
+
+  //function to write the catalog, replacing the file atomically
+  //returns errorcode
+  int write(const std::string& path) const;
+
+  //function to read a catalog
+  //returns errorcode (NON_NUMERIC_CHARACTER for a damaged catalog,
+  //including one with ids outside its key space)
+  int read(const std::string& path);
+
+};
+
+#endif
@@ -0,0 +1,98 @@
+#include <algorithm>
+#include <iostream>
+#include <thread>
+#include <vector>
+#include "catalog.h"
+#include "enigma.h"
+#include "errors.h"
+#include "tools.h"
+
+static int usage()
+{
+  std::cerr << "usage: catalog [-k rotors] [-f reflector-count] [-d distance]"
+            << " [-t threads] catalog-file plugboard-file (<reflector-file>)+"
+            << " (<rotor-file>)+\n";
+  return INSUFFICIENT_NUMBER_OF_PARAMETERS;
+}
+
+int main(int argc, char** argv)
+{
+  //-k rotors in the machine, -f number of reflector files, -d distance
+  //between the permutations of a product, -t threads
+  long options[4] = {3, 1, 3, (long) std::thread::hardware_concurrency()};
+
+  int err = take_options(argc, argv, "kfdt", options);
+  if (err != NO_ERROR)
+    {
+      cerr_tool(err);
+      return usage();
+    }
+
+  long n_rotors = options[0];
+  long n_reflectors = options[1];
+  long n_library = argc - 3 - n_reflectors;
+  if (n_rotors < 0 || n_rotors > MAX_ROTORS || n_reflectors < 1
+      || n_library < n_rotors || options[2] < 1 || options[2] > MAX_DISTANCE
+      || options[3] < 1)
+    return usage();
+
+  //load every component once, the constructors report their own errors
+  Plugboard plugboard(argv[2]);
+  if (plugboard.get_pb_error() != NO_ERROR)
+    return plugboard.get_pb_error();
+
+  Catalog catalog;
+  catalog.distance = options[2];
+  catalog.n_rotors = n_rotors;
+
+  std::vector<const Reflector*> reflectors;
+  std::vector<const RotorWiring*> library;
+  err = NO_ERROR;
+  for (int i = 0; i < n_reflectors && err == NO_ERROR; i++)
+    {
+      Reflector* reflector = new Reflector(argv[3 + i]);
+      reflectors.push_back(reflector);
+      catalog.reflectors.push_back(argv[3 + i]);
+      err = reflector->get_rf_error();
+    }
+  for (int i = 0; i < n_library && err == NO_ERROR; i++)
+    {
+      RotorWiring* rotor = new RotorWiring(argv[3 + n_reflectors + i]);
+      library.push_back(rotor);
+      catalog.rotors.push_back(argv[3 + n_reflectors + i]);
+      err = rotor->get_rot_error();
+    }
+
+  if (err == NO_ERROR)
+    {
+      err = catalog.build(plugboard, reflectors, library, options[3]);
+      if (err != NO_ERROR)
+        std::cerr << "Too many candidates for a catalog (fewer than 2^32 are"
+                  << " supported)\n";
+    }
+
+  if (err == NO_ERROR)
+    {
+      err = catalog.write(argv[1]);
+      if (err != NO_ERROR)
+        std::cerr << "Error writing catalog file " << argv[1] << "\n";
+    }
+
+  if (err == NO_ERROR)
+    {
+      size_t largest = 0;
+      for (size_t i = 0; i + 1 < catalog.starts.size(); i++)
+        largest = std::max<size_t>(largest,
+                                   catalog.starts[i + 1] - catalog.starts[i]);
+      std::cout << catalog.ids.size() << " candidates, "
+                << catalog.signatures.size() << " characteristics, largest "
+                << "class " << largest << "\n";
+    }
+
+  for (const Reflector* reflector : reflectors)
+    delete reflector;
+  for (const RotorWiring* rotor : library)
+    delete rotor;
+
+  return err;
+}
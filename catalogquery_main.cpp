@@ -0,0 +1,80 @@
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <vector>
+#include "catalog.h"
+#include "errors.h"
+#include "tools.h"
+
+int main(int argc, char** argv)
+{
+  if (argc != 2)
+    {
+      std::cerr << "usage: catalogquery catalog-file < indicators (one per"
+                << " line)\n";
+      return INSUFFICIENT_NUMBER_OF_PARAMETERS;
+    }
+
+  Catalog catalog;
+  int err = catalog.read(argv[1]);
+  if (err != NO_ERROR)
+    {
+      std::cerr << "Error reading catalog file " << argv[1] << "\n";
+      return err;
+    }
+
+  //indicators are the doubled message keys of one day, 2 * distance
+  //letters each
+  std::vector<std::vector<uint8_t>> indicators;
+  std::string line;
+  for (int number = 1; std::getline(std::cin, line); number++)
+    {
+      std::vector<uint8_t> indicator;
+      std::istringstream text(line);
+      err = read_message(text, indicator);
+      if (err != NO_ERROR)
+        {
+          cerr_tool(err);
+          return err;
+        }
+      if (indicator.empty())
+        continue;
+      if ((int) indicator.size() != 2 * catalog.distance)
+        {
+          std::cerr << "Indicator on line " << number << " does not have "
+                    << 2 * catalog.distance << " letters\n";
+          return INVALID_INDEX;
+        }
+      indicators.push_back(indicator);
+    }
+
+  Characteristic characteristic;
+  err = indicator_characteristic(indicators, catalog.distance, characteristic);
+  if (err == INSUFFICIENT_NUMBER_OF_PARAMETERS)
+    std::cerr << "Not enough indicators to find every cycle\n";
+  else if (err == INVALID_INDEX)
+    std::cerr << "Indicators are inconsistent (not from one machine)\n";
+  if (err != NO_ERROR)
+    return err;
+
+  std::cout << "# characteristic " << characteristic.describe() << "\n";
+
+  KeySpace space = catalog.space();
+  for (uint32_t id : catalog.lookup(characteristic.signature()))
+    {
+      int reflector;
+      int order[MAX_ROTORS];
+      int positions[MAX_ROTORS];
+      space.decode(id, reflector, order, positions);
+
+      std::cout << catalog.reflectors[reflector];
+      for (int r = 0; r < catalog.n_rotors; r++)
+        std::cout << " " << catalog.rotors[order[r]];
+      std::cout << " :";
+      for (int r = 0; r < catalog.n_rotors; r++)
+        std::cout << " " << positions[r];
+      std::cout << "\n";
+    }
+
+  return NO_ERROR;
+}
@@ -0,0 +1,62 @@
+#include "crib.h"
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
+
+void crib_offsets(const uint8_t cipher[], size_t length, const uint8_t crib[],
+                  size_t crib_length, std::vector<size_t>& offsets)
+{
+  offsets.clear();
+  if (crib_length == 0 || crib_length > length)
+    return;
+
+  size_t n_offsets = length - crib_length + 1;
+  size_t offset = 0;
+
+#ifdef __SSE2__
+  //64 offsets at a time: every crib letter is compared against the 64
+  //ciphertext letters under it, and the clashes are kept in registers
+  for (; offset + 64 <= n_offsets; offset += 64)
+    {
+      __m128i clash0 = _mm_setzero_si128();
+      __m128i clash1 = _mm_setzero_si128();
+      __m128i clash2 = _mm_setzero_si128();
+      __m128i clash3 = _mm_setzero_si128();
+
+      for (size_t j = 0; j < crib_length; j++)
+        {
+          const __m128i letter = _mm_set1_epi8(crib[j]);
+          const uint8_t* under = cipher + offset + j;
+          clash0 = _mm_or_si128(clash0, _mm_cmpeq_epi8(letter,
+                     _mm_loadu_si128((const __m128i*) (under))));
+          clash1 = _mm_or_si128(clash1, _mm_cmpeq_epi8(letter,
+                     _mm_loadu_si128((const __m128i*) (under + 16))));
+          clash2 = _mm_or_si128(clash2, _mm_cmpeq_epi8(letter,
+                     _mm_loadu_si128((const __m128i*) (under + 32))));
+          clash3 = _mm_or_si128(clash3, _mm_cmpeq_epi8(letter,
+                     _mm_loadu_si128((const __m128i*) (under + 48))));
+        }
+
+      uint64_t clashes = (uint64_t) (uint16_t) _mm_movemask_epi8(clash0)
+        | (uint64_t) (uint16_t) _mm_movemask_epi8(clash1) << 16
+        | (uint64_t) (uint16_t) _mm_movemask_epi8(clash2) << 32
+        | (uint64_t) (uint16_t) _mm_movemask_epi8(clash3) << 48;
+
+      uint64_t possible = ~clashes;
+      while (possible)
+        {
+          offsets.push_back(offset + __builtin_ctzll(possible));
+          possible &= possible - 1;
+        }
+    }
+#endif
+
+  for (; offset < n_offsets; offset++)
+    {
+      size_t j = 0;
+      while (j < crib_length && cipher[offset + j] != crib[j])
+        j++;
+      if (j == crib_length)
+        offsets.push_back(offset);
+    }
+}
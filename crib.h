@@ -0,0 +1,16 @@
+#ifndef CRIB_H
+#define CRIB_H
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+//function to find every offset at which a crib can lie under a ciphertext
+//the reflector has no fixed points, so the machine never encrypts a letter
+//to itself and an offset is impossible as soon as one crib letter equals
+//the ciphertext letter under it
+//cipher[] and crib[] hold letters as indexes 0-25 (any bytes work)
+//offsets receives the possible offsets in increasing order
+void crib_offsets(const uint8_t cipher[], size_t length, const uint8_t crib[],
+                  size_t crib_length, std::vector<size_t>& offsets);
+
+#endif
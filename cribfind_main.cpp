@@ -0,0 +1,61 @@
+#include <cstring>
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <vector>
+#include "crib.h"
+#include "errors.h"
+#include "tools.h"
+
+int main(int argc, char** argv)
+{
+  if (argc != 2)
+    {
+      std::cerr << "usage: cribfind CRIB < messages (one per line)\n";
+      return INSUFFICIENT_NUMBER_OF_PARAMETERS;
+    }
+
+  std::vector<uint8_t> crib;
+  std::istringstream crib_text(argv[1]);
+  int err = read_message(crib_text, crib);
+  if (err != NO_ERROR)
+    {
+      cerr_tool(err);
+      return err;
+    }
+
+  //print one line per possible placement: message number and offset
+  std::string line;
+  std::vector<uint8_t> cipher;
+  std::vector<size_t> offsets;
+  long message = 0;
+  long total = 0;
+  long possible = 0;
+
+  while (std::getline(std::cin, line))
+    {
+      cipher.clear();
+      std::istringstream text(line);
+      err = read_message(text, cipher);
+      if (err != NO_ERROR)
+        {
+          cerr_tool(err);
+          return err;
+        }
+
+      crib_offsets(cipher.data(), cipher.size(), crib.data(), crib.size(),
+                   offsets);
+      for (size_t offset : offsets)
+        std::cout << message << " " << offset << "\n";
+
+      if (cipher.size() >= crib.size())
+        total += cipher.size() - crib.size() + 1;
+      possible += offsets.size();
+      message++;
+    }
+
+  std::cerr << possible << " of " << total << " offsets possible in "
+            << message << " messages\n";
+
+  return NO_ERROR;
+}
@@ -0,0 +1,240 @@
+#include <algorithm>
+#include <atomic>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <thread>
+#include "binaryio.h"
+#include "cribindex.h"
+#include "errors.h"
+
+//number of candidates a thread takes at a time while building an index
+uint64_t const CRIBINDEX_CHUNK = 4096;
+
+//helper function to number a 4-gram
+static uint32_t gram_number(const uint8_t letters[])
+{
+  uint32_t number = 0;
+  for (int i = 0; i < GRAM_LENGTH; i++)
+    number = number * ALPHA_SIZE + letters[i];
+  return number;
+}
+
+KeySpace CribIndex::space() const
+{
+  return KeySpace(reflectors.size(), rotors.size(), n_rotors);
+}
+
+int CribIndex::build(const Plugboard& plugboard_wiring,
+                     const std::vector<const Reflector*>& reflector_library,
+                     const std::vector<const RotorWiring*>& rotor_library,
+                     int threads)
+{
+  KeySpace keys(reflector_library.size(), rotor_library.size(), n_rotors);
+  uint64_t size = keys.size();
+  uint64_t n_words = words.size();
+  if (size * n_words >= ((uint64_t) 1 << 32))
+    return INVALID_INDEX;
+
+  //4-gram and candidate value of every candidate and word, packed so that
+  //sorting groups them by 4-gram
+  std::vector<uint64_t> keyed(size * n_words);
+  std::atomic<uint64_t> next_chunk{0};
+
+  auto work = [&]()
+    {
+      KeyLoader loader(keys, plugboard_wiring, reflector_library,
+                       rotor_library);
+      uint8_t cipher[GRAM_LENGTH];
+
+      for (uint64_t begin = next_chunk++ * CRIBINDEX_CHUNK; begin < size;
+           begin = next_chunk++ * CRIBINDEX_CHUNK)
+        for (uint64_t id = begin; id < std::min(size, begin + CRIBINDEX_CHUNK);
+             id++)
+          {
+            loader.load(id);
+            MachineState start = loader.get_machine();
+            for (uint64_t w = 0; w < n_words; w++)
+              {
+                MachineState machine = start;
+                for (int i = 0; i < GRAM_LENGTH; i++)
+                  cipher[i] = machine.encrypt(words[w][i]);
+                keyed[id * n_words + w] = (uint64_t) gram_number(cipher) << 32
+                  | (id * n_words + w);
+              }
+          }
+    };
+
+  std::vector<std::thread> workers;
+  for (int t = 0; t < threads; t++)
+    workers.emplace_back(work);
+  for (std::thread& worker : workers)
+    worker.join();
+
+  std::sort(keyed.begin(), keyed.end());
+
+  //one group per 4-gram, each value stored as a varint of its
+  //difference from the one before in the group
+  grams.clear();
+  offsets.clear();
+  candidates.clear();
+  uint32_t previous = 0;
+  for (size_t i = 0; i < keyed.size(); i++)
+    {
+      uint32_t gram = keyed[i] >> 32;
+      uint32_t value = keyed[i];
+      if (i == 0 || gram != grams.back())
+        {
+          grams.push_back(gram);
+          offsets.push_back(candidates.size());
+          previous = 0;
+        }
+      for (uint32_t delta = value - previous; ; delta >>= 7)
+        {
+          if (delta < 0x80)
+            {
+              candidates.push_back(delta);
+              break;
+            }
+          candidates.push_back((delta & 0x7f) | 0x80);
+        }
+      previous = value;
+    }
+  offsets.push_back(candidates.size());
+
+  return NO_ERROR;
+}
+
+std::vector<CribCandidate> CribIndex::lookup(const uint8_t cipher[]) const
+{
+  std::vector<CribCandidate> found;
+  uint32_t gram = gram_number(cipher);
+  auto group = std::lower_bound(grams.begin(), grams.end(), gram);
+  if (group == grams.end() || *group != gram)
+    return found;
+
+  size_t index = group - grams.begin();
+  uint32_t value = 0;
+  for (size_t at = offsets[index]; at < offsets[index + 1]; )
+    {
+      uint32_t delta = 0;
+      for (int shift = 0; at < offsets[index + 1]; shift += 7)
+        {
+          uint8_t byte = candidates[at++];
+          delta |= (uint32_t) (byte & 0x7f) << shift;
+          if (!(byte & 0x80))
+            break;
+        }
+      value += delta;
+      found.push_back(CribCandidate{(int) (value % words.size()),
+                                    value / words.size()});
+    }
+
+  return found;
+}
+
+int CribIndex::write(const std::string& path) const
+{
+  std::string temporary = path + ".tmp";
+  std::ofstream out(temporary, std::ios::binary);
+  if (out.fail())
+    return ERROR_OPENING_CONFIGURATION_FILE;
+
+  out.write(CRIBINDEX_MAGIC, std::strlen(CRIBINDEX_MAGIC));
+  write_value(out, n_rotors);
+  write_name(out, plugboard);
+  write_names(out, reflectors);
+  write_names(out, rotors);
+  write_value(out, words.size());
+  for (const std::vector<uint8_t>& word : words)
+    write_array(out, word);
+  write_array(out, grams);
+  write_array(out, offsets);
+  write_array(out, candidates);
+
+  out.close();
+  if (out.fail())
+    return ERROR_OPENING_CONFIGURATION_FILE;
+
+  //rename is atomic, so readers see either the old or the new index
+  if (std::rename(temporary.c_str(), path.c_str()) != 0)
+    return ERROR_OPENING_CONFIGURATION_FILE;
+
+  return NO_ERROR;
+}
+
+int CribIndex::read(const std::string& path)
+{
+  std::ifstream in(path, std::ios::binary);
+  if (in.fail())
+    return ERROR_OPENING_CONFIGURATION_FILE;
+
+  char magic[sizeof(CRIBINDEX_MAGIC)] = {0};
+  in.read(magic, std::strlen(CRIBINDEX_MAGIC));
+  if (std::strcmp(magic, CRIBINDEX_MAGIC) != 0)
+    return NON_NUMERIC_CHARACTER;
+
+  n_rotors = read_value(in);
+  read_name(in, plugboard);
+  read_names(in, reflectors);
+  read_names(in, rotors);
+
+  //every word is read or the stream has failed
+  uint64_t count = read_count(in, MAX_NAMES);
+  words.clear();
+  for (uint64_t i = 0; i < count && in.good(); i++)
+    {
+      words.emplace_back();
+      read_array(in, words.back());
+    }
+
+  read_array(in, grams);
+  read_array(in, offsets);
+  read_array(in, candidates);
+
+  if (in.fail() || n_rotors < 0 || n_rotors > MAX_ROTORS || words.empty()
+      || offsets.size() != grams.size() + 1
+      || offsets.back() != candidates.size())
+    return NON_NUMERIC_CHARACTER;
+
+  for (const std::vector<uint8_t>& word : words)
+    if (word.size() < GRAM_LENGTH
+        || std::any_of(word.begin(), word.end(),
+                       [](uint8_t letter) { return letter >= ALPHA_SIZE; }))
+      return NON_NUMERIC_CHARACTER;
+
+  for (size_t i = 1; i < offsets.size(); i++)
+    if (offsets[i] < offsets[i - 1])
+      return NON_NUMERIC_CHARACTER;
+
+  //every candidate must be a word of the index at an id of its key space,
+  //so that lookup never hands out a candidate that cannot be decoded
+  uint64_t limit = space().size() * words.size();
+  if (limit >= ((uint64_t) 1 << 32))
+    return NON_NUMERIC_CHARACTER;
+  for (size_t index = 0; index < grams.size(); index++)
+    {
+      uint64_t value = 0;
+      for (size_t at = offsets[index]; at < offsets[index + 1]; )
+        {
+          uint64_t delta = 0;
+          bool complete = false;
+          for (int shift = 0; at < offsets[index + 1] && shift < 35;
+               shift += 7)
+            {
+              uint8_t byte = candidates[at++];
+              delta |= (uint64_t) (byte & 0x7f) << shift;
+              if (!(byte & 0x80))
+                {
+                  complete = true;
+                  break;
+                }
+            }
+          value += delta;
+          if (!complete || value >= limit)
+            return NON_NUMERIC_CHARACTER;
+        }
+    }
+
+  return NO_ERROR;
+}
@@ -0,0 +1,77 @@
+#ifndef CRIBINDEX_H
+#define CRIBINDEX_H
+#include <cstdint>
+#include <string>
+#include <vector>
+#include "keysearch.h"
+#include "machine.h"
+
+//magic string at the start of a crib index file
+#define CRIBINDEX_MAGIC "ENCRIB01"
+
+//number of ciphertext letters an index is keyed by
+int const GRAM_LENGTH = 4;
+
+//candidate found in a crib index: the word that would begin the message
+//and the candidate id in the KeySpace of the index
+struct CribCandidate {
+
+  int word;
+  uint64_t id;
+
+};
+
+//catalogue of stereotyped words (like EINS) encrypted at the start of a
+//message from every reflector, rotor order and starting position of a
+//KeySpace, under one plugboard, keyed by the first GRAM_LENGTH letters
+//of their ciphertext
+//on disk the index holds its parameters and file names, the distinct
+//4-grams in increasing order with the byte offset of their candidates,
+//and the candidates of each 4-gram as increasing values
+//id * words + word, each stored as a varint of its difference from the
+//one before
+struct CribIndex {
+
+  int n_rotors;
+
+  std::string plugboard;
+  std::vector<std::string> reflectors;
+  std::vector<std::string> rotors;
+
+  //words as indexes 0-25, at least GRAM_LENGTH letters each
+  std::vector<std::vector<uint8_t>> words;
+
+  std::vector<uint32_t> grams;
+  std::vector<uint32_t> offsets;
+  std::vector<uint8_t> candidates;
+
+  //function to compute the index on threads threads, for the n_rotors and
+  //words set beforehand
+  //plugboard_wiring, reflector_library and rotor_library are the loaded
+  //components named in plugboard, reflectors and rotors
+  //returns errorcode (INVALID_INDEX if the space has too many candidates)
+  int build(const Plugboard& plugboard_wiring,
+            const std::vector<const Reflector*>& reflector_library,
+            const std::vector<const RotorWiring*>& rotor_library,
+            int threads);
+
+  //function to get the key space the candidate ids refer to
+  KeySpace space() const;
+
+  //function to find the candidates whose ciphertext begins with a 4-gram
+  //cipher[] holds GRAM_LENGTH letters as indexes 0-25
+  //returns the candidates, in increasing order of id
+  std::vector<CribCandidate> lookup(const uint8_t cipher[]) const;
+
+  //function to write the index, replacing the file atomically
+  //returns errorcode
+  int write(const std::string& path) const;
+
+  //function to read an index
+  //returns errorcode (NON_NUMERIC_CHARACTER for a damaged index, including
+  //one with candidates outside its key space)
+  int read(const std::string& path);
+
+};
+
+#endif
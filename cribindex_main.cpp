@@ -0,0 +1,125 @@
+#include <fstream>
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+#include "cribindex.h"
+#include "enigma.h"
+#include "errors.h"
+#include "tools.h"
+
+static int usage()
+{
+  std::cerr << "usage: cribindex [-k rotors] [-f reflector-count]"
+            << " [-t threads] index-file plugboard-file words-file"
+            << " (<reflector-file>)+ (<rotor-file>)+\n";
+  return INSUFFICIENT_NUMBER_OF_PARAMETERS;
+}
+
+int main(int argc, char** argv)
+{
+  //-k rotors in the machine, -f number of reflector files, -t threads
+  long options[3] = {3, 1, (long) std::thread::hardware_concurrency()};
+
+  int err = take_options(argc, argv, "kft", options);
+  if (err != NO_ERROR)
+    {
+      cerr_tool(err);
+      return usage();
+    }
+
+  long n_rotors = options[0];
+  long n_reflectors = options[1];
+  long n_library = argc - 4 - n_reflectors;
+  if (n_rotors < 0 || n_rotors > MAX_ROTORS || n_reflectors < 1
+      || n_library < n_rotors || options[2] < 1)
+    return usage();
+
+  CribIndex index;
+  index.n_rotors = n_rotors;
+  index.plugboard = argv[2];
+
+  //stereotyped words, one per line
+  std::ifstream words(argv[3]);
+  if (words.fail())
+    {
+      std::cerr << "Error opening words file " << argv[3] << "\n";
+      return ERROR_OPENING_CONFIGURATION_FILE;
+    }
+  std::string line;
+  for (int number = 1; std::getline(words, line); number++)
+    {
+      std::vector<uint8_t> word;
+      std::istringstream text(line);
+      err = read_message(text, word);
+      if (err != NO_ERROR)
+        {
+          cerr_tool(err);
+          return err;
+        }
+      if (word.empty())
+        continue;
+      if ((int) word.size() < GRAM_LENGTH)
+        {
+          std::cerr << "Word on line " << number << " has fewer than "
+                    << GRAM_LENGTH << " letters\n";
+          return INVALID_INDEX;
+        }
+      index.words.push_back(word);
+    }
+  if (index.words.empty())
+    {
+      std::cerr << "No words in " << argv[3] << "\n";
+      return INSUFFICIENT_NUMBER_OF_PARAMETERS;
+    }
+
+  //load every component once, the constructors report their own errors
+  Plugboard plugboard(argv[2]);
+  if (plugboard.get_pb_error() != NO_ERROR)
+    return plugboard.get_pb_error();
+
+  std::vector<const Reflector*> reflectors;
+  std::vector<const RotorWiring*> library;
+  for (int i = 0; i < n_reflectors && err == NO_ERROR; i++)
+    {
+      Reflector* reflector = new Reflector(argv[4 + i]);
+      reflectors.push_back(reflector);
+      index.reflectors.push_back(argv[4 + i]);
+      err = reflector->get_rf_error();
+    }
+  for (int i = 0; i < n_library && err == NO_ERROR; i++)
+    {
+      RotorWiring* rotor = new RotorWiring(argv[4 + n_reflectors + i]);
+      library.push_back(rotor);
+      index.rotors.push_back(argv[4 + n_reflectors + i]);
+      err = rotor->get_rot_error();
+    }
+
+  if (err == NO_ERROR)
+    {
+      err = index.build(plugboard, reflectors, library, options[2]);
+      if (err != NO_ERROR)
+        std::cerr << "Too many candidates for an index (fewer than 2^32"
+                  << " candidates times words are supported)\n";
+    }
+
+  if (err == NO_ERROR)
+    {
+      err = index.write(argv[1]);
+      if (err != NO_ERROR)
+        std::cerr << "Error writing index file " << argv[1] << "\n";
+    }
+
+  if (err == NO_ERROR)
+    std::cout << index.space().size() * index.words.size() << " entries, "
+              << index.grams.size() << " 4-grams, " << index.candidates.size()
+              << " bytes of candidates\n";
+
+  for (const Reflector* reflector : reflectors)
+    delete reflector;
+  for (const RotorWiring* rotor : library)
+    delete rotor;
+
+  return err;
+}
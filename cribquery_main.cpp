@@ -0,0 +1,111 @@
+#include <algorithm>
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <vector>
+#include "cribindex.h"
+#include "enigma.h"
+#include "errors.h"
+#include "tools.h"
+
+int main(int argc, char** argv)
+{
+  if (argc != 2)
+    {
+      std::cerr << "usage: cribquery index-file < fragments (message starts,"
+                << " one per line)\n";
+      return INSUFFICIENT_NUMBER_OF_PARAMETERS;
+    }
+
+  CribIndex index;
+  int err = index.read(argv[1]);
+  if (err != NO_ERROR)
+    {
+      std::cerr << "Error reading index file " << argv[1] << "\n";
+      return err;
+    }
+
+  //the components named in the index, to check the letters of a word past
+  //its first 4-gram; the constructors report their own errors
+  std::string name = index.plugboard;
+  Plugboard plugboard(&name[0]);
+  if (plugboard.get_pb_error() != NO_ERROR)
+    return plugboard.get_pb_error();
+
+  std::vector<const Reflector*> reflectors;
+  std::vector<const RotorWiring*> library;
+  for (size_t i = 0; i < index.reflectors.size() && err == NO_ERROR; i++)
+    {
+      name = index.reflectors[i];
+      Reflector* reflector = new Reflector(&name[0]);
+      reflectors.push_back(reflector);
+      err = reflector->get_rf_error();
+    }
+  for (size_t i = 0; i < index.rotors.size() && err == NO_ERROR; i++)
+    {
+      name = index.rotors[i];
+      RotorWiring* rotor = new RotorWiring(&name[0]);
+      library.push_back(rotor);
+      err = rotor->get_rot_error();
+    }
+
+  KeyLoader loader(index.space(), plugboard, reflectors, library);
+
+  std::string line;
+  for (int number = 1; err == NO_ERROR && std::getline(std::cin, line);
+       number++)
+    {
+      std::vector<uint8_t> fragment;
+      std::istringstream text(line);
+      err = read_message(text, fragment);
+      if (err != NO_ERROR)
+        {
+          cerr_tool(err);
+          break;
+        }
+      if (fragment.empty())
+        continue;
+      if ((int) fragment.size() < GRAM_LENGTH)
+        {
+          std::cerr << "Fragment on line " << number << " has fewer than "
+                    << GRAM_LENGTH << " letters\n";
+          err = INVALID_INDEX;
+          break;
+        }
+
+      std::cout << "# " << line << "\n";
+      for (const CribCandidate& candidate : index.lookup(fragment.data()))
+        {
+          loader.load(candidate.id);
+          const int* order = loader.get_order();
+          const int* positions = loader.get_positions();
+
+          //the 4-gram matched, the rest of the word must match as well
+          const std::vector<uint8_t>& word = index.words[candidate.word];
+          size_t length = std::min(word.size(), fragment.size());
+          MachineState machine = loader.get_machine();
+          size_t i = 0;
+          while (i < length && machine.encrypt(word[i]) == fragment[i])
+            i++;
+          if (i < length)
+            continue;
+
+          for (uint8_t letter : word)
+            std::cout << (char) ('A' + letter);
+          std::cout << " " << index.reflectors[loader.get_reflector()];
+          for (int r = 0; r < index.n_rotors; r++)
+            std::cout << " " << index.rotors[order[r]];
+          std::cout << " :";
+          for (int r = 0; r < index.n_rotors; r++)
+            std::cout << " " << positions[r];
+          std::cout << "\n";
+        }
+    }
+
+  for (const Reflector* reflector : reflectors)
+    delete reflector;
+  for (const RotorWiring* rotor : library)
+    delete rotor;
+
+  return err;
+}
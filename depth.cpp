@@ -0,0 +1,144 @@
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+#include <thread>
+#include "depth.h"
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
+
+//number of messages per side of a tile of pairs
+int const TILE_MESSAGES = 64;
+
+size_t count_coincidences(const uint8_t a[], const uint8_t b[], size_t length)
+{
+  size_t count = 0;
+  size_t i = 0;
+
+#ifdef __SSE2__
+  //equal bytes compare to 0xff, so subtracting the compare counts them in
+  //byte lanes; the lanes are summed before they can overflow
+  const __m128i zero = _mm_setzero_si128();
+  while (i + 16 <= length)
+    {
+      __m128i lanes = _mm_setzero_si128();
+      size_t stop = std::min(length - 15, i + 255 * 16);
+      for (; i < stop; i += 16)
+        {
+          __m128i x = _mm_loadu_si128((const __m128i*) (a + i));
+          __m128i y = _mm_loadu_si128((const __m128i*) (b + i));
+          lanes = _mm_sub_epi8(lanes, _mm_cmpeq_epi8(x, y));
+        }
+      __m128i sums = _mm_sad_epu8(lanes, zero);
+      count += _mm_cvtsi128_si32(sums)
+        + _mm_cvtsi128_si32(_mm_unpackhi_epi64(sums, sums));
+    }
+#endif
+
+  for (; i < length; i++)
+    if (a[i] == b[i])
+      count++;
+
+  return count;
+}
+
+DepthSearch::DepthSearch(int max_offset, int min_overlap, double min_z)
+  : max_offset(max_offset), min_overlap(min_overlap), min_z(min_z)
+{
+}
+
+void DepthSearch::add(const uint8_t message[], int message_length)
+{
+  start.push_back(letters.size());
+  length.push_back(message_length);
+  letters.insert(letters.end(), message, message + message_length);
+}
+
+void DepthSearch::compare(int i, int j, std::vector<DepthResult>& found) const
+{
+  const double p = 1.0 / 26;
+
+  for (int offset = -max_offset; offset <= max_offset; offset++)
+    {
+      const uint8_t* a = letters.data() + start[i];
+      const uint8_t* b = letters.data() + start[j];
+      int length_a = length[i];
+      int length_b = length[j];
+      if (offset >= 0)
+        {
+          a += offset;
+          length_a -= offset;
+        }
+      else
+        {
+          b -= offset;
+          length_b += offset;
+        }
+
+      int overlap = std::min(length_a, length_b);
+      if (overlap < min_overlap || overlap <= 0)
+        continue;
+
+      int coincidences = count_coincidences(a, b, overlap);
+      double z = (coincidences - overlap * p)
+        / std::sqrt(overlap * p * (1 - p));
+      if (z >= min_z)
+        found.push_back(DepthResult{i, j, offset, overlap, coincidences, z});
+    }
+}
+
+std::vector<DepthResult> DepthSearch::search(int threads) const
+{
+  if (threads < 1)
+    threads = 1;
+
+  int n_messages = length.size();
+  int n_blocks = (n_messages + TILE_MESSAGES - 1) / TILE_MESSAGES;
+
+  //tiles (bi, bj) with bi <= bj cover every pair once
+  std::vector<std::pair<int, int>> tiles;
+  for (int bi = 0; bi < n_blocks; bi++)
+    for (int bj = bi; bj < n_blocks; bj++)
+      tiles.push_back(std::make_pair(bi, bj));
+
+  std::atomic<size_t> next_tile(0);
+  std::vector<std::vector<DepthResult>> found(threads);
+  std::vector<std::thread> workers;
+
+  for (int w = 0; w < threads; w++)
+    workers.emplace_back([&, w]()
+      {
+        size_t tile;
+        while ((tile = next_tile.fetch_add(1)) < tiles.size())
+          {
+            int bi = tiles[tile].first;
+            int bj = tiles[tile].second;
+            int end_i = std::min(n_messages, (bi + 1) * TILE_MESSAGES);
+            int end_j = std::min(n_messages, (bj + 1) * TILE_MESSAGES);
+            for (int i = bi * TILE_MESSAGES; i < end_i; i++)
+              for (int j = std::max(i + 1, bj * TILE_MESSAGES); j < end_j; j++)
+                compare(i, j, found[w]);
+          }
+      });
+
+  for (std::thread& worker : workers)
+    worker.join();
+
+  std::vector<DepthResult> results;
+  for (const std::vector<DepthResult>& part : found)
+    results.insert(results.end(), part.begin(), part.end());
+
+  std::sort(results.begin(), results.end(),
+            [](const DepthResult& a, const DepthResult& b)
+            {
+              if (a.z != b.z)
+                return a.z > b.z;
+              if (a.first != b.first)
+                return a.first < b.first;
+              if (a.second != b.second)
+                return a.second < b.second;
+              return a.offset < b.offset;
+            });
+
+  return results;
+}
@@ -0,0 +1,65 @@
+#ifndef DEPTH_H
+#define DEPTH_H
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+//pair of messages that look like they were encrypted in depth
+//message second starts offset letters into message first (or first
+//starts -offset letters into second when offset is negative)
+struct DepthResult {
+
+  int first;
+  int second;
+  int offset;
+
+  //number of aligned letters and how many of them are equal
+  int overlap;
+  int coincidences;
+
+  //standard score of the coincidences against random text
+  double z;
+
+};
+
+//function to count the positions at which two runs of letters are equal
+//a[] and b[] hold length letters (any bytes work)
+//returns number of coincidences
+size_t count_coincidences(const uint8_t a[], const uint8_t b[], size_t length);
+
+//detector for messages in depth over a corpus
+//messages encrypted from the same machine state agree in about 1 letter
+//in 15 (the coincidence rate of the language) where unrelated messages
+//agree in 1 in 26, so every pair is compared at every offset up to
+//max_offset and pairs scoring at least min_z are reported
+class DepthSearch {
+
+  //messages as indexes 0-25, stored back to back
+  std::vector<uint8_t> letters;
+  std::vector<size_t> start;
+  std::vector<int> length;
+
+  int max_offset;
+  int min_overlap;
+  double min_z;
+
+  //helper function to compare one pair at every offset
+  void compare(int i, int j, std::vector<DepthResult>& found) const;
+
+ public:
+
+  DepthSearch(int max_offset, int min_overlap, double min_z);
+
+  //function to add a message to the corpus
+  //message[] holds length letters as indexes 0-25
+  void add(const uint8_t message[], int length);
+
+  //function to compare every pair of messages
+  //the pairs are split into tiles of messages that fit in cache together,
+  //and threads take tiles until none are left
+  //returns the pairs found, best first
+  std::vector<DepthResult> search(int threads) const;
+
+};
+
+#endif
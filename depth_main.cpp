@@ -0,0 +1,55 @@
+#include <cstdio>
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+#include "depth.h"
+#include "errors.h"
+#include "tools.h"
+
+int main(int argc, char** argv)
+{
+  //-o maximum offset, -m minimum overlap, -z minimum score in tenths,
+  //-t threads
+  long options[4] = {0, 30, 40, (long) std::thread::hardware_concurrency()};
+
+  int err = take_options(argc, argv, "omzt", options);
+  if (err != NO_ERROR || argc != 1 || options[0] < 0 || options[1] < 1)
+    {
+      cerr_tool(err);
+      std::cerr << "usage: depth [-o max-offset] [-m min-overlap] "
+                << "[-z min-score-tenths] [-t threads] < messages (one per "
+                << "line)\n";
+      return err != NO_ERROR ? err : INSUFFICIENT_NUMBER_OF_PARAMETERS;
+    }
+
+  DepthSearch search(options[0], options[1], options[2] / 10.0);
+
+  std::string line;
+  std::vector<uint8_t> message;
+  while (std::getline(std::cin, line))
+    {
+      message.clear();
+      std::istringstream text(line);
+      err = read_message(text, message);
+      if (err != NO_ERROR)
+        {
+          cerr_tool(err);
+          return err;
+        }
+      search.add(message.data(), message.size());
+    }
+
+  std::cout << "# first second offset overlap coincidences score\n";
+  for (const DepthResult& result : search.search(options[3]))
+    {
+      char line[128];
+      std::snprintf(line, sizeof(line), "%d %d %d %d %d %.2f\n",
+                    result.first, result.second, result.offset,
+                    result.overlap, result.coincidences, result.z);
+      std::cout << line;
+    }
+
+  return NO_ERROR;
+}
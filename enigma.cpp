@@ -4,18 +4,38 @@
 #include <algorithm>
 #include "enigma.h"
 #include "errors.h"
+#include "machine.h"
+#include "trace.h"
 
-Enigma::Enigma(int argc, char** argv)
+Enigma::Enigma(int argc, char** argv, bool interactive)
 {
   errorcode = setup(argc, argv);
   cerr_enigma();
-  if (errorcode == NO_ERROR)
+  if (errorcode == NO_ERROR && interactive)
     {
       errorcode = encrypt_message();
       cerr_enigma();
     }
 }
 
+Enigma::Enigma(const Enigma& loaded)
+  : errorcode(loaded.errorcode), n_rotors(loaded.n_rotors),
+    pb_ptr(loaded.pb_ptr), rf_ptr(loaded.rf_ptr), wirings(loaded.wirings),
+    owner(false)
+{
+  if (loaded.existing_rotors > 0)
+    {
+      rot_ptr = new RotorList();
+      for (Rotor* current = loaded.rot_ptr->find_leftmost();
+           current != nullptr; current = current->right)
+        {
+          //same wiring and position, links are set by append_rotor
+          rot_ptr->append_rotor(new Rotor(*current));
+          existing_rotors++;
+        }
+    }
+}
+
 int Enigma::setup(int argc, char** argv)
 {
   if (argc < 4)
@@ -78,11 +98,11 @@ int Enigma::setup(int argc, char** argv)
       rot_ptr = new RotorList();
       for (int count = 0; count < n_rotors; count++)
         {
-          Rotor* new_rot_ptr;
-          new_rot_ptr = new Rotor(argv[count+3]);
-          if (new_rot_ptr->get_rot_error() != NO_ERROR)
-            return new_rot_ptr->get_rot_error();
-          rot_ptr->append_rotor(new_rot_ptr);
+          RotorWiring* new_wiring_ptr = new RotorWiring(argv[count+3]);
+          wirings.push_back(new_wiring_ptr);
+          if (new_wiring_ptr->get_rot_error() != NO_ERROR)
+            return new_wiring_ptr->get_rot_error();
+          rot_ptr->append_rotor(new Rotor(new_wiring_ptr));
           existing_rotors++;
         }
       //Set rotors to start position
@@ -110,9 +130,17 @@ int Enigma::setup(int argc, char** argv)
 
 int Enigma::encrypt_message()
 {
+  return encrypt_message(std::cin, std::cout);
+}
+
+int Enigma::encrypt_message(std::istream& in, std::ostream& out)
+{
+#ifdef BYTE_ALPHABET
+  return encrypt_bytes(in, out);
+#else
   std::string message;
 
-  std::getline (std::cin,message);
+  std::getline (in,message);
 
   //Strip message of any whitespace
   message.erase(std::remove(message.begin(), message.end(), ' '),
@@ -136,50 +164,114 @@ int Enigma::encrypt_message()
           return INVALID_INPUT_CHARACTER;
         }
       letter = encrypt(letter);
-      std::cout << letter;
+      out << letter;
+    }
+
+  return NO_ERROR;
+#endif
+}
+
+int Enigma::encrypt_bytes(std::istream& in, std::ostream& out)
+{
+  //every byte is a valid symbol, so the input is not stripped or validated
+  //and is encrypted in place one block at a time
+  char block[65536];
+
+  while (in.read(block, sizeof(block)) || in.gcount() > 0)
+    {
+      std::streamsize length = in.gcount();
+      for (std::streamsize i = 0; i < length; i++)
+        block[i] = encrypt(block[i]);
+      out.write(block, length);
     }
 
   return NO_ERROR;
 }
 
-char Enigma::encrypt(char letter)
+symbol Enigma::encrypt(symbol letter)
 {
   keypress();
 
+  TRACE(TraceRecord trace = TraceRecord());
+  TRACE(trace.input = letter);
+  TRACE(trace.n_rotors = n_rotors < TRACE_ROTORS ? n_rotors : TRACE_ROTORS);
+
   letter = pb_ptr->pb_encrypt(letter);
 
+  TRACE(trace.plugboard = letter);
+
   if (n_rotors > 0)
     {
       Rotor* current = rot_ptr->find_rightmost();
+      TRACE(int r = 0);
 
       while (current != nullptr)
         {
           letter = current->rot_fw_encrypt(letter);
+          TRACE(if (r < TRACE_ROTORS) trace.forward[r] = letter);
+          TRACE(if (r < TRACE_ROTORS)
+                  trace.position[r] = current->get_position());
+          TRACE(r++);
           current = current->left;
         }
 
       letter = rf_ptr->rf_encrypt(letter);
 
+      TRACE(trace.reflector = letter);
+
       current = rot_ptr->find_leftmost();
+      TRACE(r = 0);
 
       while (current != nullptr)
         {
           letter = current->rot_bw_encrypt(letter);
+          TRACE(if (r < TRACE_ROTORS) trace.backward[r] = letter);
+          TRACE(r++);
           current = current->right;
         }
 
       letter = pb_ptr->pb_encrypt(letter);
 
+      TRACE(trace.output = letter);
+      TRACE(trace_record(trace));
+
       return letter;
     }
   
   letter = rf_ptr->rf_encrypt(letter);
 
+  TRACE(trace.reflector = letter);
+
   letter = pb_ptr->pb_encrypt(letter);
 
+  TRACE(trace.output = letter);
+  TRACE(trace_record(trace));
+
   return letter;
 }
 
+int Enigma::compile(Wiring& wiring, MachineState& state)
+{
+  if (errorcode != NO_ERROR)
+    return errorcode;
+
+  int err = wiring.setup(*pb_ptr, *rf_ptr, wirings.data(), n_rotors);
+  if (err != NO_ERROR)
+    return err;
+
+  state.wiring = &wiring;
+
+  if (n_rotors > 0)
+    {
+      int r = 0;
+      for (Rotor* current = rot_ptr->find_leftmost(); current != nullptr;
+           current = current->right)
+        state.position[r++] = current->get_position();
+    }
+
+  return NO_ERROR;
+}
+
 void Enigma::keypress()
 {
   if (n_rotors > 0)
@@ -235,12 +327,19 @@ int Enigma::get_enigma_error()
 
 Enigma::~Enigma()
 {
-  if (pb_ptr != nullptr)
-    delete pb_ptr;
+  if (owner)
+    {
+      if (pb_ptr != nullptr)
+        delete pb_ptr;
 
-  if (rf_ptr != nullptr)
-    delete rf_ptr;
+      if (rf_ptr != nullptr)
+        delete rf_ptr;
+
+      for (const RotorWiring* wiring : wirings)
+        delete wiring;
+    }
 
+  //the list is made before its first rotor, which may fail to load
   if (existing_rotors > 0)
     {
       Rotor* current = rot_ptr->find_leftmost();
@@ -250,6 +349,6 @@ Enigma::~Enigma()
           delete current->left;
         }
       delete current;
-      delete rot_ptr;
     }
+  delete rot_ptr;
 }
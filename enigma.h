@@ -1,22 +1,47 @@
 #ifndef ENIGMA_H
 #define ENIGMA_H
+#include <cstdint>
 #include <fstream>
+#include <vector>
 #include "errors.h"
 
 //global constants for configuration arrays
+//the alphabet is fixed at compile time: by default the machine works on
+//the letters A-Z, building with -DBYTE_ALPHABET gives a 256-symbol machine
+//which works on raw bytes (FIRST_SYMBOL is the symbol stored at index 0)
+#ifdef BYTE_ALPHABET
+int const ALPHA_SIZE = 256;
+int const FIRST_SYMBOL = 0;
+#else
 int const ALPHA_SIZE = 26;
+int const FIRST_SYMBOL = 'A';
+#endif
 int const MIN_INDEX = ALPHA_SIZE - ALPHA_SIZE;
 int const MAX_INDEX = ALPHA_SIZE - 1;
 
+//symbols are unsigned so that bytes above 127 still index the arrays
+typedef unsigned char symbol;
+
+//rotor offsets lie in [-MAX_INDEX, MAX_INDEX], so the narrowest type that
+//holds them keeps the rotor tables small (78 bytes for letters)
+#ifdef BYTE_ALPHABET
+typedef short rotor_offset;
+#else
+typedef signed char rotor_offset;
+#endif
+
+struct Wiring;
+struct MachineState;
+
 class Plugboard {
 
   int errorcode;
 
-  //array of characters mapping letters to other letters
+  //array of symbols mapping letters to other letters
   //letters are represented as indexes 0-25
-  //for each index (corresponding to a letter) there is a character
+  //for each index (corresponding to a letter) there is a symbol
   //which corresponds to the letter it is mapped to
-  char pb_mapping[ALPHA_SIZE];
+  symbol pb_mapping[ALPHA_SIZE];
 
   //function to set up plugboard mapping
   //configuration[] is mapping file
@@ -30,7 +55,7 @@ class Plugboard {
   //index is index in mapping array
   //letter is letter being checked for double occurrence
   //returns true if a letter appears twice in mapping, false otherwise
-  bool repetition(int index, char letter);
+  bool repetition(int index, symbol letter);
 
   //function for plug errors
   //err is errorcode used to print informative message to errorstream
@@ -42,10 +67,10 @@ class Plugboard {
   //function to encrypt a letter
   //letter is letter to encrypt
   //returns encrypted letter
-  char pb_encrypt(char letter);
+  symbol pb_encrypt(symbol letter) const;
 
   //getter function for errorcode
-  int get_pb_error();
+  int get_pb_error() const;
   
 };
 
@@ -53,11 +78,11 @@ class Reflector {
 
   int errorcode;
 
-  //array of characters mapping letters to other letters
+  //array of symbols mapping letters to other letters
   //letters are represented as indexes 0-25
-  //for each index (corresponding to a letter) there is a character
+  //for each index (corresponding to a letter) there is a symbol
   //which corresponds to the letter it is mapped to
-  char rf_mapping[ALPHA_SIZE];
+  symbol rf_mapping[ALPHA_SIZE];
 
   //function to set up reflector mapping
   //configuration[] is mapping file
@@ -71,7 +96,7 @@ class Reflector {
   //index is index in mapping array
   //letter is letter being checked for double occurrence
   //returns true if a letter appears twice in mapping, false otherwise
-  bool repetition(int index, char letter);
+  bool repetition(int index, symbol letter);
 
   //function for refl errors
   //err is errorcode used to print informative message to errorstream
@@ -86,33 +111,31 @@ class Reflector {
   //function to encrypt a letter
   //letter is letter to encrypt
   //returns encrypted letter
-  char rf_encrypt(char letter);
+  symbol rf_encrypt(symbol letter) const;
 
   //getter function for errorcode
-  int get_rf_error();
+  int get_rf_error() const;
   
 };
 
-class Rotor {
+//read-only wiring of a rotor, loaded once from its configuration file
+//nothing changes it after setup, so one RotorWiring can be shared by the
+//rotors of any number of machines on any number of threads
+class RotorWiring {
   
   int errorcode;
 
-  //arrays of integers mapping letters to other letters
+  //arrays of offsets mapping letters to other letters at position 0
   //letters are represented as indexes 0-25
-  //for each index (corresponding to a letter) there is an integer
+  //for each index (corresponding to a letter) there is an offset
   //which corresponds to the offset of the mapping: to obtain the
-  //output letter, it is sufficient to add the integer to the index
-  int fw_map[ALPHA_SIZE];
-  int bw_map[ALPHA_SIZE];
+  //output letter, it is sufficient to add the offset to the index
+  rotor_offset fw_map[ALPHA_SIZE];
+  rotor_offset bw_map[ALPHA_SIZE];
 
-  //array of integers representing notches
-  //there can be max 26 notches
-  //a null notch is represented by a -1
-  //letters are represented as indexes 0-25
-  int notches[ALPHA_SIZE];
-
-  //counter of rotations used to check whether a notch is reached
-  int rotations;
+  //notch[p] is true if the rotor turns its left neighbour when it
+  //reaches position p
+  bool notch[ALPHA_SIZE];
 
   //function to set up rotor mappings
   //configuration[] is mapping file
@@ -123,13 +146,48 @@ class Rotor {
   //input_value[] is storage for values from config file
   void initialize_rot_arrays(int input_value[]);
 
-  //helper function to rotate the rotor
-  //array[] the array to be rotated
-  void rotate_array(int array[]);
+  //functions for rot err
+  //err is errorcode used to print informative message to errorstream
+  //count, output1 and output2 are used to print specific mapping error messages
+  void cerr_rot(int err, char configuration[]);
+  void cerr_rot_map(int count, int output1, int output2, char configuration[]);
 
  public:
+
+  RotorWiring(char configuration[]);
+
+  //functions to encrypt a character using fw and bw mappings
+  //letter is letter to encrypt
+  //position is the position of the rotor (number of rotations)
+  //return encrypted letter
+  symbol fw_encrypt(symbol letter, int position) const;
+  symbol bw_encrypt(symbol letter, int position) const;
+
+  //function to check if there is a notch at a position
+  bool is_notch(int position) const;
+
+  //function to copy the wiring into compact tables as it is at position 0
+  //fw[] and bw[] receive the mappings as indexes 0-25
+  //notches[] receives true for every position with a notch
+  void compile(uint8_t fw[], uint8_t bw[], bool notches[]) const;
+
+  //getter function for errorcode
+  int get_rot_error() const;
   
-  Rotor(char configuration[]);
+};
+
+//rotor of one machine: a cursor over shared wiring holding the position
+//of the rotor and its links to its neighbours
+class Rotor {
+  
+  const RotorWiring* wiring;
+
+  //counter of rotations used to check whether a notch is reached
+  int rotations = 0;
+
+ public:
+  
+  Rotor(const RotorWiring* wiring);
   Rotor* left;
   Rotor* right;
   int starting_position;
@@ -140,8 +198,8 @@ class Rotor {
   //functions to encrypt a character using fw and bw mappings
   //letter is letter to encrypt
   //return encrypted letter
-  char rot_fw_encrypt(char letter);
-  char rot_bw_encrypt(char letter);
+  symbol rot_fw_encrypt(symbol letter);
+  symbol rot_bw_encrypt(symbol letter);
 
   //function to check if a notch is at the top position
   bool is_notch();
@@ -149,14 +207,8 @@ class Rotor {
   //function to position the rotor to its starting position
   void start();
 
-  //functions for rot err
-  //err is errorcode used to print informative message to errorstream
-  //count, output1 and output2 are used to print specific mapping error messages
-  void cerr_rot(int err, char configuration[]);
-  void cerr_rot_map(int count, int output1, int output2, char configuration[]);
-
-  //getter function for errorcode
-  int get_rot_error();
+  //getter function for the current position (number of rotations)
+  int get_position();
   
 };
 
@@ -189,9 +241,17 @@ class Enigma {
   //number of successfully created rotors
   int existing_rotors = 0;
   
-  Plugboard* pb_ptr = nullptr;
-  Reflector* rf_ptr = nullptr;
-  RotorList* rot_ptr;
+  //the plugboard, reflector and rotor wirings are read-only once set up
+  //and are shared with every copy of the machine; only the machine that
+  //loaded them (the owner) deletes them
+  const Plugboard* pb_ptr = nullptr;
+  const Reflector* rf_ptr = nullptr;
+  std::vector<const RotorWiring*> wirings;
+  bool owner = true;
+
+  //the rotors (positions and links) belong to this machine only, null
+  //when it has none
+  RotorList* rot_ptr = nullptr;
 
   //function to set up enigma components
   //argc is argument counter
@@ -202,7 +262,13 @@ class Enigma {
   //function to encrypt a message letter by letter
   //letter is letter to encrypt
   //returns encrypted letter
-  char encrypt(char letter);
+  symbol encrypt(symbol letter);
+
+  //function to encrypt raw bytes from an input stream in blocks,
+  //used instead of encrypt_message by the 256-symbol machine
+  //in and out are the streams to read from and write to
+  //returns errorcode
+  int encrypt_bytes(std::istream& in, std::ostream& out);
 
   //function to rotate the rotors when a key is pressed
   void keypress();
@@ -215,11 +281,31 @@ class Enigma {
 
  public:
   
-  Enigma(int argc, char** argv);
+  //interactive is false when the machine is only set up from its
+  //configuration files and std input is left alone
+  Enigma(int argc, char** argv, bool interactive = true);
+
+  //copy constructor: the copy shares the read-only components of the
+  //machine but has its own rotors at the same positions, so copies can
+  //encrypt concurrently on different threads without locks
+  //the copied machine must outlive its copies
+  Enigma(const Enigma& loaded);
+  Enigma& operator=(const Enigma&) = delete;
+
   ~Enigma();
 
   //function to encrypt a message from std input stream
   int encrypt_message();
+
+  //function to encrypt a message from an input stream
+  //in and out are the streams to read from and write to
+  //returns errorcode
+  int encrypt_message(std::istream& in, std::ostream& out);
+
+  //function to compile the configured machine into shared tables and a
+  //compact state at the current rotor positions
+  //returns errorcode
+  int compile(Wiring& wiring, MachineState& state);
   
   //getter function for errorcode
   int get_enigma_error();
@@ -10,4 +10,8 @@
 #define INVALID_REFLECTOR_MAPPING                 9
 #define INCORRECT_NUMBER_OF_REFLECTOR_PARAMETERS  10
 #define ERROR_OPENING_CONFIGURATION_FILE          11
+#define TOO_MANY_ROTORS                           12
+#define PERFORMANCE_REGRESSION                    13
+#define ERROR_READING_OR_WRITING_FILE             14
+#define WRONG_FILE_VERSION                        15
 #define NO_ERROR                                  0
@@ -0,0 +1,60 @@
+#include <algorithm>
+#include <atomic>
+#include <thread>
+#include "errors.h"
+#include "indicator.h"
+
+//number of records a thread takes at a time
+size_t const INDICATOR_CHUNK = 256;
+
+IndicatorDecoder::IndicatorDecoder(const MachineState& ground, int repeats)
+  : ground(ground), repeats(repeats)
+{
+}
+
+int IndicatorDecoder::decrypt(IndicatorRecord& record) const
+{
+  int n_rotors = ground.wiring->n_rotors;
+  if ((int) record.indicator.size() != repeats * n_rotors)
+    return record.errorcode = INVALID_INDEX;
+
+  MachineState machine = ground;
+  for (uint8_t& letter : record.indicator)
+    letter = machine.encrypt(letter);
+
+  //a repeated key must decrypt to the same letters every time
+  for (int i = n_rotors; i < repeats * n_rotors; i++)
+    if (record.indicator[i] != record.indicator[i - n_rotors])
+      return record.errorcode = INVALID_INDEX;
+
+  for (int r = 0; r < n_rotors; r++)
+    record.positions[r] = record.indicator[r];
+  record.indicator.resize(n_rotors);
+
+  machine.start(record.positions);
+  for (uint8_t& letter : record.body)
+    letter = machine.encrypt(letter);
+
+  return record.errorcode = NO_ERROR;
+}
+
+void IndicatorDecoder::decrypt_all(std::vector<IndicatorRecord>& records,
+                                   int threads) const
+{
+  std::atomic<size_t> next{0};
+  auto work = [&]()
+    {
+      for (size_t begin = next.fetch_add(INDICATOR_CHUNK);
+           begin < records.size();
+           begin = next.fetch_add(INDICATOR_CHUNK))
+        for (size_t i = begin;
+             i < std::min(records.size(), begin + INDICATOR_CHUNK); i++)
+          decrypt(records[i]);
+    };
+
+  std::vector<std::thread> workers;
+  for (int t = 0; t < threads; t++)
+    workers.emplace_back(work);
+  for (std::thread& worker : workers)
+    worker.join();
+}
@@ -0,0 +1,52 @@
+#ifndef INDICATOR_H
+#define INDICATOR_H
+#include <cstdint>
+#include <vector>
+#include "machine.h"
+
+//message sent under the indicator procedure: the starting positions of
+//the message (its message key) encrypted at the ground setting of the
+//day, followed by the body encrypted from those positions
+//letters are represented as indexes 0-25
+struct IndicatorRecord {
+
+  std::vector<uint8_t> indicator;
+  std::vector<uint8_t> body;
+
+  //filled in by IndicatorDecoder: the message key, one position per
+  //rotor leftmost first, and errorcode
+  int positions[MAX_ROTORS];
+  int errorcode;
+
+};
+
+//decoder of indicator procedure traffic for one machine
+//every record is decrypted from a copy of the ground setting, and the copy
+//is rekeyed in place to the recovered message key, so no configuration
+//is read again
+class IndicatorDecoder {
+
+  //machine at the ground setting
+  MachineState ground;
+
+  //number of times the message key is sent in an indicator (2 for the
+  //doubled keys of early traffic)
+  int repeats;
+
+ public:
+
+  IndicatorDecoder(const MachineState& ground, int repeats);
+
+  //function to decrypt a record in place: its indicator becomes the
+  //message key and its body the plaintext
+  //returns errorcode (INVALID_INDEX if the indicator has the wrong length
+  //or its repeats disagree)
+  int decrypt(IndicatorRecord& record) const;
+
+  //function to decrypt records on threads threads
+  //the errorcode of each record is left in the record
+  void decrypt_all(std::vector<IndicatorRecord>& records, int threads) const;
+
+};
+
+#endif
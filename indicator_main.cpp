@@ -0,0 +1,110 @@
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+#include "enigma.h"
+#include "errors.h"
+#include "indicator.h"
+#include "machine.h"
+#include "tools.h"
+
+//number of records read, decrypted and printed at a time
+size_t const RECORDS_PER_ROUND = 65536;
+
+static int usage()
+{
+  std::cerr << "usage: indicator [-r repeats] [-t threads] plugboard-file"
+            << " reflector-file (<rotor-file>)* ground-positions < records"
+            << " (indicator and body, one per line)\n";
+  return INSUFFICIENT_NUMBER_OF_PARAMETERS;
+}
+
+int main(int argc, char** argv)
+{
+  //-r times the message key is repeated in an indicator, -t threads
+  long options[2] = {1, (long) std::thread::hardware_concurrency()};
+
+  int err = take_options(argc, argv, "rt", options);
+  if (err != NO_ERROR)
+    {
+      cerr_tool(err);
+      return usage();
+    }
+  if (argc < 4 || options[0] < 1 || options[1] < 1)
+    return usage();
+
+  //the configuration is read once, its positions are the ground setting
+  Enigma enigma(argc, argv, false);
+  if (enigma.get_enigma_error() != NO_ERROR)
+    return enigma.get_enigma_error();
+
+  Wiring wiring;
+  MachineState ground;
+  err = enigma.compile(wiring, ground);
+  if (err != NO_ERROR)
+    {
+      cerr_tool(err);
+      return err;
+    }
+
+  IndicatorDecoder decoder(ground, options[0]);
+  int result = NO_ERROR;
+  std::vector<IndicatorRecord> records;
+  std::vector<int> lines;
+  std::string line;
+  int number = 0;
+
+  while (std::cin)
+    {
+      records.clear();
+      lines.clear();
+      while (records.size() < RECORDS_PER_ROUND && std::getline(std::cin, line))
+        {
+          number++;
+          std::istringstream fields(line);
+          std::string indicator;
+          if (!(fields >> indicator))
+            continue;
+
+          IndicatorRecord record;
+          std::istringstream indicator_text(indicator);
+          err = read_message(indicator_text, record.indicator);
+          if (err == NO_ERROR)
+            err = read_message(fields, record.body);
+          if (err != NO_ERROR)
+            {
+              cerr_tool(err);
+              std::cerr << "(record on line " << number << ")\n";
+              result = err;
+              continue;
+            }
+          records.push_back(record);
+          lines.push_back(number);
+        }
+
+      decoder.decrypt_all(records, options[1]);
+
+      for (size_t i = 0; i < records.size(); i++)
+        {
+          const IndicatorRecord& record = records[i];
+          if (record.errorcode != NO_ERROR)
+            {
+              std::cerr << "Indicator on line " << lines[i] << " does not"
+                        << " decrypt to a message key\n";
+              result = record.errorcode;
+              continue;
+            }
+
+          std::string text;
+          for (uint8_t letter : record.indicator)
+            text += letter + 'A';
+          text += ' ';
+          for (uint8_t letter : record.body)
+            text += letter + 'A';
+          std::cout << text << "\n";
+        }
+    }
+
+  return result;
+}
@@ -0,0 +1,215 @@
+#include <algorithm>
+#include <cstring>
+#include "keycache.h"
+
+KeystreamCache::Components::Components(const Wiring& wiring)
+{
+  n_rotors = wiring.n_rotors;
+  std::memcpy(plugboard, wiring.plugboard, sizeof(plugboard));
+  std::memcpy(reflector, wiring.reflector, sizeof(reflector));
+  std::memcpy(fw, wiring.fw, n_rotors * sizeof(fw[0]));
+  std::memcpy(notch, wiring.notch, n_rotors * sizeof(notch[0]));
+}
+
+bool KeystreamCache::Components::matches(const Wiring& wiring) const
+{
+  return n_rotors == wiring.n_rotors
+    && std::memcmp(plugboard, wiring.plugboard, sizeof(plugboard)) == 0
+    && std::memcmp(reflector, wiring.reflector, sizeof(reflector)) == 0
+    && std::memcmp(fw, wiring.fw, n_rotors * sizeof(fw[0])) == 0
+    && std::memcmp(notch, wiring.notch, n_rotors * sizeof(notch[0])) == 0;
+}
+
+bool KeystreamCache::Key::operator==(const Key& other) const
+{
+  return wiring == other.wiring
+    && std::memcmp(position, other.position, sizeof(position)) == 0;
+}
+
+size_t KeystreamCache::KeyHash::operator()(const Key& key) const
+{
+  uint64_t hash = (uintptr_t) key.wiring.get();
+  for (int r = 0; r < MAX_ROTORS; r++)
+    hash = (hash ^ key.position[r]) * 1099511628211ULL;
+  return hash ^ (hash >> 29);
+}
+
+KeystreamCache::KeystreamCache(size_t capacity_bytes)
+{
+  //a segment costs its tables plus a list node and an index node, and at
+  //worst components of its own
+  size_t entry_bytes = sizeof(Segment) + sizeof(Entry) + sizeof(Key)
+    + 8 * sizeof(void*) + sizeof(Components) + sizeof(Interned)
+    + 8 * sizeof(void*);
+  shard_capacity = std::max<size_t>(1, capacity_bytes / entry_bytes
+                                    / CACHE_SHARDS);
+}
+
+std::shared_ptr<const KeystreamCache::Components>
+KeystreamCache::intern(const Wiring& wiring)
+{
+  std::lock_guard<std::mutex> guard(interned_lock);
+  auto range = interned.equal_range(wiring.fingerprint);
+  for (auto found = range.first; found != range.second; found++)
+    if (found->second.components->matches(wiring))
+      {
+        //components whose last key has just gone are waiting for
+        //release() and cannot be taken back
+        std::shared_ptr<const Components> shared = found->second.shared.lock();
+        if (shared)
+          return shared;
+      }
+
+  uint64_t fingerprint = wiring.fingerprint;
+  const Components* components = new Components(wiring);
+  std::shared_ptr<const Components> shared(
+    components, [this, fingerprint](const Components* released)
+    {
+      release(fingerprint, released);
+    });
+  interned.emplace(fingerprint, Interned{components, shared});
+  return shared;
+}
+
+void KeystreamCache::release(uint64_t fingerprint,
+                             const Components* components)
+{
+  {
+    std::lock_guard<std::mutex> guard(interned_lock);
+    auto range = interned.equal_range(fingerprint);
+    for (auto found = range.first; found != range.second; found++)
+      if (found->second.components == components)
+        {
+          interned.erase(found);
+          break;
+        }
+  }
+  delete components;
+}
+
+std::shared_ptr<const KeystreamCache::Segment>
+KeystreamCache::lookup(const MachineState& state,
+                       const std::shared_ptr<const Components>& wiring,
+                       int steps)
+{
+  Key key;
+  key.wiring = wiring;
+  //positions past the last rotor are not kept up by the machine
+  std::memset(key.position, 0, sizeof(key.position));
+  std::memcpy(key.position, state.position, state.wiring->n_rotors);
+
+  Shard& shard = shards[KeyHash()(key) % CACHE_SHARDS];
+  {
+    std::lock_guard<std::mutex> guard(shard.lock);
+    auto found = shard.index.find(key);
+    if (found != shard.index.end() && found->second->segment->steps >= steps)
+      {
+        shard.hits++;
+        shard.entries.splice(shard.entries.begin(), shard.entries,
+                             found->second);
+        return found->second->segment;
+      }
+    shard.misses++;
+  }
+
+  //walk the rotors outside the lock; another thread may cache the same
+  //segment meanwhile, in which case the longer copy is kept
+  std::shared_ptr<Segment> segment = std::make_shared<Segment>();
+  segment->steps = steps;
+  MachineState machine = state;
+  for (int t = 0; t < steps; t++)
+    {
+      machine.keypress();
+      machine.permutation(segment->perm[t]);
+    }
+  std::memcpy(segment->position, machine.position, state.wiring->n_rotors);
+
+  std::lock_guard<std::mutex> guard(shard.lock);
+  auto found = shard.index.find(key);
+  if (found != shard.index.end())
+    {
+      if (found->second->segment->steps < steps)
+        found->second->segment = segment;
+      shard.entries.splice(shard.entries.begin(), shard.entries,
+                           found->second);
+      return segment;
+    }
+
+  if (shard.entries.size() >= shard_capacity)
+    {
+      shard.index.erase(shard.entries.back().key);
+      shard.entries.pop_back();
+      shard.evictions++;
+    }
+
+  shard.entries.push_front({key, segment});
+  shard.index[key] = shard.entries.begin();
+  return segment;
+}
+
+void KeystreamCache::encrypt(MachineState& state, const symbol in[],
+                             symbol out[], size_t length)
+{
+  if (length == 0)
+    return;
+
+  std::shared_ptr<const Components> wiring = intern(*state.wiring);
+  size_t done = 0;
+  while (done < length)
+    {
+      int steps = std::min<size_t>(CACHE_SEGMENT, length - done);
+      std::shared_ptr<const Segment> segment = lookup(state, wiring, steps);
+      for (int t = 0; t < steps; t++)
+        out[done + t] = segment->perm[t][in[done + t] - FIRST_SYMBOL]
+          + FIRST_SYMBOL;
+      done += steps;
+
+      //a whole segment leaves the machine at its recorded positions, the
+      //rest of a longer one is stepped through directly
+      if (steps == segment->steps)
+        std::memcpy(state.position, segment->position, state.wiring->n_rotors);
+      else
+        for (int t = 0; t < steps; t++)
+          state.keypress();
+    }
+}
+
+size_t KeystreamCache::get_hits()
+{
+  size_t total = 0;
+  for (Shard& shard : shards)
+    {
+      std::lock_guard<std::mutex> guard(shard.lock);
+      total += shard.hits;
+    }
+  return total;
+}
+
+size_t KeystreamCache::get_misses()
+{
+  size_t total = 0;
+  for (Shard& shard : shards)
+    {
+      std::lock_guard<std::mutex> guard(shard.lock);
+      total += shard.misses;
+    }
+  return total;
+}
+
+size_t KeystreamCache::get_evictions()
+{
+  size_t total = 0;
+  for (Shard& shard : shards)
+    {
+      std::lock_guard<std::mutex> guard(shard.lock);
+      total += shard.evictions;
+    }
+  return total;
+}
+
+double KeystreamCache::get_hit_rate()
+{
+  size_t hits = get_hits();
+  size_t lookups = hits + get_misses();
+  return lookups ? (double) hits / lookups : 0;
+}
@@ -0,0 +1,137 @@
+#ifndef KEYCACHE_H
+#define KEYCACHE_H
+#include <cstddef>
+#include <cstdint>
+#include <list>
+#include <memory>
+#include <mutex>
+#include <unordered_map>
+#include "machine.h"
+
+//number of steps whose permutations are cached together
+int const CACHE_SEGMENT = 64;
+
+//number of independently locked parts of a KeystreamCache
+int const CACHE_SHARDS = 16;
+
+//per-process cache of the permutations a machine applies at each step,
+//keyed by the components of its wiring and the rotor positions
+//permutations are cached in segments of up to CACHE_SEGMENT consecutive
+//steps keyed by the positions before the first step, so a lookup serves
+//many letters; a message that starts where an earlier message started (or
+//where one of its segments started) reuses the permutations instead of
+//walking the rotors, and as the positions of a machine only depend on
+//where they were, it then stays on the cached segments to its end
+//a segment only holds the steps a message needed, and is replaced by a
+//longer one when a longer message needs more
+//memory is bounded and the least recently used segments are evicted first
+//the components of a wiring are kept while a segment of it is cached, and
+//are counted against the bound as if every segment had its own
+//the cache is split into shards with their own locks, so it can be shared
+//by any number of threads
+class KeystreamCache {
+
+  //components of a wiring (see Wiring::fingerprint), kept so that two
+  //wirings whose fingerprints collide never share segments
+  struct Components {
+    int n_rotors;
+    uint8_t plugboard[ALPHA_SIZE];
+    uint8_t reflector[ALPHA_SIZE];
+    uint8_t fw[MAX_ROTORS][ALPHA_SIZE];
+    bool notch[MAX_ROTORS][ALPHA_SIZE];
+
+    Components(const Wiring& wiring);
+    bool matches(const Wiring& wiring) const;
+  };
+
+  //wiring is the interned components of the machine, so equal components
+  //always give the same pointer while any key holds them
+  struct Key {
+    std::shared_ptr<const Components> wiring;
+    uint8_t position[MAX_ROTORS];
+    bool operator==(const Key& other) const;
+  };
+
+  struct KeyHash {
+    size_t operator()(const Key& key) const;
+  };
+
+  //permutations of the first steps steps and the positions after them
+  struct Segment {
+    int steps;
+    uint8_t perm[CACHE_SEGMENT][ALPHA_SIZE];
+    uint8_t position[MAX_ROTORS];
+  };
+
+  //segments are shared with the machines using them, so an evicted
+  //segment lives on until they are done with it
+  struct Entry {
+    Key key;
+    std::shared_ptr<const Segment> segment;
+  };
+
+  struct Shard {
+    std::mutex lock;
+
+    //most recently used entry first
+    std::list<Entry> entries;
+    std::unordered_map<Key, std::list<Entry>::iterator, KeyHash> index;
+
+    size_t hits = 0;
+    size_t misses = 0;
+    size_t evictions = 0;
+  };
+
+  //interned components, held by the keys using them: the last key to go
+  //takes them out of the map
+  struct Interned {
+    const Components* components;
+    std::weak_ptr<const Components> shared;
+  };
+
+  //maximum number of segments in each shard
+  size_t shard_capacity;
+
+  //components of the wirings in use, by fingerprint
+  //declared before the shards, whose keys remove their entries as the
+  //shards are destroyed
+  std::mutex interned_lock;
+  std::unordered_multimap<uint64_t, Interned> interned;
+
+  Shard shards[CACHE_SHARDS];
+
+  //helper function to find the interned components of a wiring, adding
+  //them if they are not in use
+  std::shared_ptr<const Components> intern(const Wiring& wiring);
+
+  //helper function to remove interned components once no key holds them
+  void release(uint64_t fingerprint, const Components* components);
+
+  //helper function to find the segment starting at the positions of a
+  //machine with at least steps steps, computing and caching it on a miss
+  std::shared_ptr<const Segment> lookup(
+    const MachineState& state,
+    const std::shared_ptr<const Components>& wiring, int steps);
+
+ public:
+
+  //capacity_bytes bounds the memory used by the cached segments, including
+  //their list and index overhead
+  KeystreamCache(size_t capacity_bytes);
+
+  //function to encrypt a run of symbols through the cache, leaving the
+  //machine where MachineState::encrypt would
+  //in and out may be the same buffer
+  void encrypt(MachineState& state, const symbol in[], symbol out[],
+               size_t length);
+
+  //getter functions for the statistics, summed over the shards
+  //hits and misses count segment lookups
+  size_t get_hits();
+  size_t get_misses();
+  size_t get_evictions();
+  double get_hit_rate();
+
+};
+
+#endif
@@ -0,0 +1,83 @@
+#include <iostream>
+#include <vector>
+#include "errors.h"
+#include "keysearch.h"
+#include "tools.h"
+
+int main(int argc, char** argv)
+{
+  //-n results printed
+  long options[1] = {10};
+
+  int err = take_options(argc, argv, "n", options);
+  if (err != NO_ERROR || argc < 2 || options[0] < 1)
+    {
+      cerr_tool(err);
+      std::cerr << "usage: keymerge [-n top] (<checkpoint-file>)+\n";
+      return err != NO_ERROR ? err : INSUFFICIENT_NUMBER_OF_PARAMETERS;
+    }
+
+  Checkpoint first;
+  TopResults top(options[0]);
+  std::vector<int> seen;
+  uint64_t remaining = 0;
+
+  for (int i = 1; i < argc; i++)
+    {
+      Checkpoint checkpoint;
+      err = checkpoint.read(argv[i]);
+      if (err == WRONG_FILE_VERSION)
+        {
+          std::cerr << "Checkpoint file " << argv[i] << " was written by "
+                    << "another version of keysearch\n";
+          return err;
+        }
+      if (err != NO_ERROR)
+        {
+          std::cerr << "Error reading checkpoint file " << argv[i] << "\n";
+          return err;
+        }
+
+      if (i == 1)
+        {
+          first = checkpoint;
+          seen.assign(first.n_shards, 0);
+        }
+      else if (checkpoint.fingerprint != first.fingerprint)
+        {
+          std::cerr << "Checkpoint file " << argv[i] << " belongs to a "
+                    << "different search than " << argv[1] << "\n";
+          return INVALID_INDEX;
+        }
+
+      //the same shard twice would count its results twice, so the files
+      //given are not the shards of one search
+      if (seen[checkpoint.shard])
+        {
+          std::cerr << "Shard " << checkpoint.shard << " given twice, in "
+                    << argv[seen[checkpoint.shard]] << " and " << argv[i]
+                    << "\n";
+          return INVALID_INDEX;
+        }
+      seen[checkpoint.shard] = i;
+      remaining += checkpoint.end - checkpoint.next;
+
+      for (const KeyResult& result : checkpoint.results)
+        top.add(result);
+    }
+
+  //partial results are still printed, but say what they are missing
+  for (int shard = 0; shard < first.n_shards; shard++)
+    if (!seen[shard])
+      std::cerr << "Shard " << shard << " of " << first.n_shards
+                << " is missing\n";
+  if (remaining > 0)
+    std::cerr << remaining << " candidates not searched yet\n";
+
+  KeySpace space(first.reflectors.size(), first.rotors.size(),
+                 first.n_rotors);
+  for (const KeyResult& result : top.sorted())
+    print_result(std::cout, space, first, result);
+
+  return NO_ERROR;
+}
@@ -0,0 +1,556 @@
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <fstream>
+#include <iomanip>
+#include "binaryio.h"
+#include "errors.h"
+#include "keysearch.h"
+
+KeySpace::KeySpace(int n_reflectors, int n_library, int n_rotors)
+  : n_reflectors(n_reflectors), n_library(n_library), n_rotors(n_rotors)
+{
+  //a library with fewer rotors than the machine gives no orders at all
+  n_orders = 1;
+  n_positions = 1;
+  for (int r = 0; r < n_rotors; r++)
+    {
+      n_orders *= std::max(n_library - r, 0);
+      n_positions *= ALPHA_SIZE;
+    }
+}
+
+uint64_t KeySpace::size() const
+{
+  return n_reflectors * n_orders * n_positions;
+}
+
+uint64_t KeySpace::positions() const
+{
+  return n_positions;
+}
+
+int KeySpace::rotors() const
+{
+  return n_rotors;
+}
+
+void KeySpace::decode(uint64_t id, int& reflector, int order[],
+                      int positions[]) const
+{
+  uint64_t position = id % n_positions;
+  uint64_t rotors = id / n_positions % n_orders;
+  reflector = id / n_positions / n_orders;
+
+  //the rightmost rotor turns fastest
+  for (int r = n_rotors - 1; r >= 0; r--)
+    {
+      positions[r] = position % ALPHA_SIZE;
+      position /= ALPHA_SIZE;
+    }
+
+  //pick each rotor from the ones not used yet
+  std::vector<int> available;
+  for (int i = 0; i < n_library; i++)
+    available.push_back(i);
+  for (int r = 0; r < n_rotors; r++)
+    {
+      int pick = rotors % available.size();
+      rotors /= available.size();
+      order[r] = available[pick];
+      available.erase(available.begin() + pick);
+    }
+}
+
+void KeySpace::shard(int i, int n_shards, uint64_t& begin, uint64_t& end) const
+{
+  //split by whole orders where possible, so that a shard rarely needs
+  //more Wirings than it has to
+  uint64_t blocks = size() / n_positions;
+  if (blocks >= (uint64_t) n_shards)
+    {
+      begin = blocks * i / n_shards * n_positions;
+      end = blocks * (i + 1) / n_shards * n_positions;
+      return;
+    }
+  begin = size() * i / n_shards;
+  end = size() * (i + 1) / n_shards;
+}
+
+KeyLoader::KeyLoader(const KeySpace& space, const Plugboard& plugboard,
+                     const std::vector<const Reflector*>& reflector_library,
+                     const std::vector<const RotorWiring*>& rotor_library)
+  : space(space), plugboard(plugboard), reflector_library(reflector_library),
+    rotor_library(rotor_library)
+{
+}
+
+bool KeyLoader::load(uint64_t id)
+{
+  int n_rotors = space.rotors();
+  if (id / space.positions() == block)
+    {
+      uint64_t position = id % space.positions();
+      for (int r = n_rotors - 1; r >= 0; r--)
+        {
+          positions[r] = position % ALPHA_SIZE;
+          position /= ALPHA_SIZE;
+        }
+      return false;
+    }
+
+  block = id / space.positions();
+  space.decode(id, reflector, order, positions);
+  const RotorWiring* rotors[MAX_ROTORS];
+  for (int r = 0; r < n_rotors; r++)
+    rotors[r] = rotor_library[order[r]];
+  wiring.setup(plugboard, *reflector_library[reflector], rotors, n_rotors);
+  return true;
+}
+
+int KeyLoader::get_reflector() const
+{
+  return reflector;
+}
+
+const int* KeyLoader::get_order() const
+{
+  return order;
+}
+
+const int* KeyLoader::get_positions() const
+{
+  return positions;
+}
+
+const Wiring& KeyLoader::get_wiring() const
+{
+  return wiring;
+}
+
+MachineState KeyLoader::get_machine() const
+{
+  MachineState machine;
+  machine.wiring = &wiring;
+  machine.start(positions);
+  return machine;
+}
+
+GrayWalk::GrayWalk(const Wiring& wiring, uint64_t rank)
+  : n_rotors(wiring.n_rotors), rank(rank)
+{
+  count = 1;
+  for (int r = 0; r < n_rotors; r++)
+    count *= ALPHA_SIZE;
+
+  //the digits of a rank run up and down in turn: a rotor's digit counts
+  //down while the digit on its left is odd
+  for (int r = n_rotors - 1; r >= 0; r--)
+    {
+      digits[r] = rank % ALPHA_SIZE;
+      rank /= ALPHA_SIZE;
+    }
+  for (int r = 0; r < n_rotors; r++)
+    positions[r] = r > 0 && digits[r - 1] % 2 == 1
+      ? MAX_INDEX - digits[r] : digits[r];
+
+  unrotated.wiring = &wiring;
+  for (int r = 0; r < MAX_ROTORS; r++)
+    unrotated.position[r] = 0;
+  rebuild(0);
+}
+
+const MachineState& GrayWalk::before(int r) const
+{
+  return r == 0 ? unrotated : runs[r - 1][positions[r - 1]];
+}
+
+void GrayWalk::rebuild(int r)
+{
+  for (; r < n_rotors; r++)
+    {
+      runs[r][0] = before(r);
+      for (int k = 1; k <= positions[r]; k++)
+        {
+          runs[r][k] = runs[r][k - 1];
+          runs[r][k].rotate(r);
+        }
+    }
+}
+
+bool GrayWalk::next()
+{
+  if (rank + 1 >= count)
+    return false;
+  rank++;
+
+  //the rotors on the right of the one that changes are at the end of
+  //their run, where the reflected code leaves them in place
+  int r = n_rotors - 1;
+  while (digits[r] == MAX_INDEX)
+    {
+      digits[r] = 0;
+      r--;
+    }
+  digits[r]++;
+
+  //a step back finds the machine already in the run of rotor r
+  if (r == 0 || digits[r - 1] % 2 == 0)
+    {
+      positions[r]++;
+      runs[r][positions[r]] = runs[r][positions[r] - 1];
+      runs[r][positions[r]].rotate(r);
+    }
+  else
+    positions[r]--;
+  rebuild(r + 1);
+  return true;
+}
+
+uint64_t GrayWalk::get_rank() const
+{
+  return rank;
+}
+
+uint64_t GrayWalk::get_index() const
+{
+  uint64_t index = 0;
+  for (int r = 0; r < n_rotors; r++)
+    index = index * ALPHA_SIZE + positions[r];
+  return index;
+}
+
+const int* GrayWalk::get_positions() const
+{
+  return positions;
+}
+
+const MachineState& GrayWalk::get_machine() const
+{
+  return before(n_rotors);
+}
+
+//helper function ordering results from worst to best
+static bool worse(const KeyResult& a, const KeyResult& b)
+{
+  if (a.score != b.score)
+    return a.score < b.score;
+  return a.id > b.id;
+}
+
+//helper function for the min-heap, which keeps the worst result in front
+static bool heap_order(const KeyResult& a, const KeyResult& b)
+{
+  return worse(b, a);
+}
+
+TopResults::TopResults(int capacity)
+  : capacity(capacity)
+{
+}
+
+void TopResults::add(const KeyResult& result)
+{
+  if ((int) heap.size() < capacity)
+    {
+      heap.push_back(result);
+      std::push_heap(heap.begin(), heap.end(), heap_order);
+      return;
+    }
+
+  if (capacity == 0 || !worse(heap.front(), result))
+    return;
+
+  std::pop_heap(heap.begin(), heap.end(), heap_order);
+  heap.back() = result;
+  std::push_heap(heap.begin(), heap.end(), heap_order);
+}
+
+bool TopResults::admits(double score) const
+{
+  return (int) heap.size() < capacity || score >= heap.front().score;
+}
+
+double TopResults::threshold() const
+{
+  return (int) heap.size() < capacity ? 0 : heap.front().score;
+}
+
+std::vector<KeyResult> TopResults::sorted() const
+{
+  std::vector<KeyResult> results(heap);
+  std::sort(results.begin(), results.end(),
+            [](const KeyResult& a, const KeyResult& b) { return worse(b, a); });
+  return results;
+}
+
+int Checkpoint::write(const std::string& path) const
+{
+  std::string temporary = path + ".tmp";
+  std::ofstream out(temporary);
+  if (out.fail())
+    return ERROR_OPENING_CONFIGURATION_FILE;
+
+  out << "keysearch-checkpoint 2\n"
+      << "fingerprint " << fingerprint << "\n"
+      << "shard " << shard << " " << n_shards << "\n"
+      << "rotors " << n_rotors << "\n"
+      << "range " << begin << " " << next << " " << end << "\n"
+      << "plugboard-file\n" << plugboard << "\n"
+      << "reflector-files " << reflectors.size() << "\n";
+  for (const std::string& file : reflectors)
+    out << file << "\n";
+  out << "rotor-files " << rotors.size() << "\n";
+  for (const std::string& file : rotors)
+    out << file << "\n";
+  out << "results " << results.size() << "\n" << std::setprecision(17);
+  for (const KeyResult& result : results)
+    out << result.score << " " << result.id << "\n";
+
+  out.close();
+  if (out.fail())
+    return ERROR_OPENING_CONFIGURATION_FILE;
+
+  //rename is atomic, so a crash leaves either the old or the new file
+  if (std::rename(temporary.c_str(), path.c_str()) != 0)
+    return ERROR_OPENING_CONFIGURATION_FILE;
+
+  return NO_ERROR;
+}
+
+int Checkpoint::read(const std::string& path)
+{
+  std::ifstream in(path);
+  if (in.fail())
+    return ERROR_OPENING_CONFIGURATION_FILE;
+
+  std::string word;
+  int version;
+  size_t count;
+
+  in >> word >> version;
+  if (word != "keysearch-checkpoint" || in.fail())
+    return NON_NUMERIC_CHARACTER;
+  if (version != 2)
+    return WRONG_FILE_VERSION;
+
+  in >> word >> fingerprint >> word >> shard >> n_shards >> word >> n_rotors
+     >> word >> begin >> next >> end >> word;
+  in.ignore();
+  std::getline(in, plugboard);
+
+  //counts are checked before anything is allocated for them, so that a
+  //damaged file cannot make the reader allocate without bound
+  in >> word >> count;
+  in.ignore();
+  if (in.fail() || count > MAX_NAMES)
+    return NON_NUMERIC_CHARACTER;
+  reflectors.resize(count);
+  for (std::string& file : reflectors)
+    std::getline(in, file);
+
+  in >> word >> count;
+  in.ignore();
+  if (in.fail() || count > MAX_NAMES)
+    return NON_NUMERIC_CHARACTER;
+  rotors.resize(count);
+  for (std::string& file : rotors)
+    std::getline(in, file);
+
+  if (in.fail() || n_shards < 1 || shard < 0 || shard >= n_shards
+      || n_rotors < 0 || n_rotors > MAX_ROTORS || begin > next || next > end)
+    return NON_NUMERIC_CHARACTER;
+
+  //a shard keeps at most one result per candidate it has tried, and only
+  //candidates of its key space
+  in >> word >> count;
+  if (in.fail() || count > next - begin)
+    return NON_NUMERIC_CHARACTER;
+  uint64_t size = KeySpace(reflectors.size(), rotors.size(), n_rotors).size();
+  results.resize(count);
+  for (KeyResult& result : results)
+    {
+      in >> result.score >> result.id;
+      if (result.id >= size)
+        in.setstate(std::ios::failbit);
+    }
+
+  if (in.fail())
+    return NON_NUMERIC_CHARACTER;
+
+  return NO_ERROR;
+}
+
+void print_result(std::ostream& out, const KeySpace& space,
+                  const Checkpoint& checkpoint, const KeyResult& result)
+{
+  int reflector;
+  int order[MAX_ROTORS];
+  int positions[MAX_ROTORS];
+  space.decode(result.id, reflector, order, positions);
+
+  out << std::fixed << std::setprecision(4) << result.score << " "
+      << checkpoint.reflectors[reflector];
+  for (int r = 0; r < checkpoint.n_rotors; r++)
+    out << " " << checkpoint.rotors[order[r]];
+  out << " :";
+  for (int r = 0; r < checkpoint.n_rotors; r++)
+    out << " " << positions[r];
+  out << "\n";
+}
+
+//helper function to compute the index of coincidence from letter counts
+static double coincidence(const long counts[], int length)
+{
+  double sum = 0;
+  for (int i = MIN_INDEX; i <= MAX_INDEX; i++)
+    sum += counts[i] * (counts[i] - 1);
+  return sum * ALPHA_SIZE / ((double) length * (length - 1));
+}
+
+double score_decryption(MachineState machine, const uint8_t cipher[],
+                        int length)
+{
+  if (length < 2)
+    return 0;
+
+  long counts[ALPHA_SIZE] = {0};
+  for (int t = 0; t < length; t++)
+    counts[machine.encrypt(cipher[t])]++;
+
+  return coincidence(counts, length);
+}
+
+double score_decryption(BlockEngine& engine, MachineState machine,
+                        const symbol cipher[], symbol plain[], int length)
+{
+  if (length < 2)
+    return 0;
+
+  engine.encrypt(machine, cipher, plain, length);
+  long counts[ALPHA_SIZE] = {0};
+  for (int t = 0; t < length; t++)
+    counts[plain[t] - FIRST_SYMBOL]++;
+
+  return coincidence(counts, length);
+}
+
+//number of letters decrypted between two checks of a TrialDecryptor
+int const TRIAL_CHUNK = 16;
+
+//variance of the letter frequencies of a text per unit of coincidence
+//rate above that of random letters (English: 0.0011 at 0.066 - 1/26)
+double const LANGUAGE_SPREAD = 0.04;
+
+//helper function to find how many standard deviations below the mean a
+//normal variable is with probability tail
+static double normal_bound(double tail)
+{
+  double low = 0;
+  double high = 40;
+  for (int i = 0; i < 100; i++)
+    {
+      double middle = (low + high) / 2;
+      if (0.5 * std::erfc(middle / std::sqrt(2.0)) > tail)
+        low = middle;
+      else
+        high = middle;
+    }
+  return high;
+}
+
+TrialDecryptor::TrialDecryptor(double rejection, int min_letters)
+  : rejection(rejection), min_letters(std::max(min_letters, 2))
+{
+}
+
+//helper function for the spread of the coincidence rate of done letters
+//from a text at rate, whose letter frequencies vary by language
+static double rate_spread(double rate, double language, int done)
+{
+  double all = (double) done * (done - 1) / 2;
+  return std::sqrt(4 * language / done + rate * (1 - rate) / all);
+}
+
+bool TrialDecryptor::decrypt(BlockEngine& engine, MachineState machine,
+                             const symbol cipher[], symbol plain[],
+                             int length, double threshold, double& score)
+{
+  candidates++;
+
+  //nothing to test against while any score enters the top results, or
+  //while random letters would do
+  double random = 1.0 / ALPHA_SIZE;
+  double rate = threshold / ALPHA_SIZE;
+  if (rejection <= 0 || rate <= random || length <= min_letters)
+    {
+      letters += length;
+      score = score_decryption(engine, machine, cipher, plain, length);
+      return true;
+    }
+
+  //the chance of a wrong rejection is shared out between the checks, and
+  //checks before even random letters could be told from the threshold
+  //are skipped
+  double language = LANGUAGE_SPREAD * (rate - random);
+  if (length != tested_length || threshold != tested_threshold)
+    {
+      int checks = (length - min_letters + TRIAL_CHUNK - 1) / TRIAL_CHUNK;
+      bound = normal_bound(rejection / checks);
+      first_check = min_letters;
+      while (first_check < length && random >= rate
+             - bound * rate_spread(rate, language, first_check))
+        first_check += TRIAL_CHUNK;
+      tested_length = length;
+      tested_threshold = threshold;
+    }
+  if (first_check >= length)
+    {
+      letters += length;
+      score = score_decryption(engine, machine, cipher, plain, length);
+      return true;
+    }
+
+  long counts[ALPHA_SIZE] = {0};
+  long pairs = 0;
+  int done = 0;
+  while (done < length)
+    {
+      int run = std::min(done < first_check ? first_check - done
+                         : TRIAL_CHUNK, length - done);
+      engine.encrypt(machine, cipher + done, plain + done, run);
+      for (int t = done; t < done + run; t++)
+        pairs += counts[plain[t] - FIRST_SYMBOL]++;
+      done += run;
+      if (done == length)
+        break;
+
+      double all = (double) done * (done - 1) / 2;
+      if (pairs / all < rate - bound * rate_spread(rate, language, done))
+        {
+          letters += done;
+          abandoned++;
+          score = pairs / all * ALPHA_SIZE;
+          return false;
+        }
+    }
+
+  letters += length;
+  score = coincidence(counts, length);
+  return true;
+}
+
+uint64_t TrialDecryptor::get_candidates() const
+{
+  return candidates;
+}
+
+uint64_t TrialDecryptor::get_abandoned() const
+{
+  return abandoned;
+}
+
+uint64_t TrialDecryptor::get_letters() const
+{
+  return letters;
+}
@@ -0,0 +1,307 @@
+#ifndef KEYSEARCH_H
+#define KEYSEARCH_H
+#include <cstdint>
+#include <iostream>
+#include <string>
+#include <vector>
+#include "block.h"
+#include "machine.h"
+
+//candidate key kept by a search
+//id numbers the candidate in its KeySpace and score is the index of
+//coincidence of the decryption under it
+struct KeyResult {
+
+  double score;
+  uint64_t id;
+
+};
+
+//enumeration of reflector x rotor order x starting positions
+//candidate ids run over the starting positions fastest, then over the
+//rotor orders and then over the reflectors, so a contiguous range of ids
+//only needs a new Wiring every 26^n_rotors candidates
+class KeySpace {
+
+  int n_reflectors;
+
+  //number of rotors in the library and in the machine
+  int n_library;
+  int n_rotors;
+
+  uint64_t n_orders;
+  uint64_t n_positions;
+
+ public:
+
+  KeySpace(int n_reflectors, int n_library, int n_rotors);
+
+  //getter function for the number of candidates
+  uint64_t size() const;
+
+  //getter function for the number of starting positions of each order
+  uint64_t positions() const;
+
+  //getter function for the number of rotors in the machine
+  int rotors() const;
+
+  //function to decode a candidate id
+  //reflector receives the index of the reflector in its library
+  //order[] receives n_rotors indexes into the rotor library, leftmost first
+  //positions[] receives n_rotors starting positions, leftmost first
+  void decode(uint64_t id, int& reflector, int order[], int positions[]) const;
+
+  //function to find the candidates of shard i of n_shards
+  //the shards are contiguous, disjoint ranges covering the whole space
+  //begin and end receive the first id and one past the last id
+  void shard(int i, int n_shards, uint64_t& begin, uint64_t& end) const;
+
+};
+
+//machine for the candidates of a KeySpace, set up from loaded components
+//the wiring is only set up again when the reflector or rotor order
+//changes, so loading the candidates of a contiguous range of ids in turn
+//only decodes the starting positions of most of them
+//a loader belongs to one thread; the components must outlive it
+class KeyLoader {
+
+  KeySpace space;
+
+  const Plugboard& plugboard;
+  const std::vector<const Reflector*>& reflector_library;
+  const std::vector<const RotorWiring*>& rotor_library;
+
+  Wiring wiring;
+
+  //reflector and rotor order the wiring is set up for
+  uint64_t block = UINT64_MAX;
+
+  int reflector;
+  int order[MAX_ROTORS];
+  int positions[MAX_ROTORS];
+
+ public:
+
+  //the libraries are those the KeySpace was made for
+  KeyLoader(const KeySpace& space, const Plugboard& plugboard,
+            const std::vector<const Reflector*>& reflector_library,
+            const std::vector<const RotorWiring*>& rotor_library);
+
+  KeyLoader(const KeyLoader&) = delete;
+  KeyLoader& operator=(const KeyLoader&) = delete;
+
+  //function to load a candidate, which must be below space.size()
+  //returns true if the wiring was set up again (and so moved)
+  bool load(uint64_t id);
+
+  //getter functions for the loaded candidate, as KeySpace::decode gives it
+  int get_reflector() const;
+  const int* get_order() const;
+  const int* get_positions() const;
+
+  //getter function for the wiring of the loaded candidate
+  const Wiring& get_wiring() const;
+
+  //function to get the machine at the starting positions of the loaded
+  //candidate
+  MachineState get_machine() const;
+
+};
+
+//walk over the starting positions of one rotor order in reflected base-26
+//Gray code order: from one step to the next only one rotor's starting
+//position changes, and only by one
+//the machine at the starting positions is updated rather than set up
+//again: runs[r][k] is the machine with rotors 0 to r-1 already rotated to
+//their starting positions and rotor r rotated k times, kept for every k up
+//to its starting position, so a change of rotor r keeps the runs of rotors
+//0 to r, a step forward is one rotation and a step back is a lookup (its
+//rotations are the last ones MachineState::start makes for that rotor)
+//with the rotors on the left standing still for long stretches, the cores
+//a BlockEngine caches for them also carry over from candidate to candidate
+class GrayWalk {
+
+  int n_rotors;
+
+  uint64_t rank;
+  uint64_t count;
+
+  //digits of rank (leftmost rotor first) and the starting positions they
+  //map to
+  int digits[MAX_ROTORS];
+  int positions[MAX_ROTORS];
+
+  MachineState unrotated;
+  MachineState runs[MAX_ROTORS][ALPHA_SIZE];
+
+  //helper function for the machine with rotors 0 to r-1 at their starting
+  //positions
+  const MachineState& before(int r) const;
+
+  //helper function to rotate rotors r onwards to their starting positions
+  //from before(r)
+  void rebuild(int r);
+
+ public:
+
+  //wiring is the rotor order walked over, rank the first step
+  GrayWalk(const Wiring& wiring, uint64_t rank = 0);
+
+  //function to move on to the next step
+  //returns false (and stays put) after the last one
+  bool next();
+
+  //getter function for the number of steps taken from the first position
+  uint64_t get_rank() const;
+
+  //getter function for the starting positions as a KeySpace position,
+  //that is an id modulo KeySpace::positions()
+  uint64_t get_index() const;
+
+  //getter function for the starting positions, leftmost first
+  const int* get_positions() const;
+
+  //getter function for the machine at the starting positions
+  const MachineState& get_machine() const;
+
+};
+
+//best results seen so far, at most capacity of them
+//ties in score go to the lower id so that results are repeatable
+class TopResults {
+
+  int capacity;
+
+  //min-heap on (score, -id): the worst kept result is at the front
+  std::vector<KeyResult> heap;
+
+ public:
+
+  TopResults(int capacity);
+
+  //function to offer a result, kept if it is among the best so far
+  void add(const KeyResult& result);
+
+  //function to check whether a score could still be kept
+  //returns true if a result with this score may enter the top results
+  bool admits(double score) const;
+
+  //function to get the lowest score that may still enter the top results
+  //returns 0 while there is room for any result
+  double threshold() const;
+
+  //function to get the kept results, best first
+  std::vector<KeyResult> sorted() const;
+
+};
+
+//progress of one shard, written to disk so that a shard can resume after
+//a crash and shards can be merged by keymerge
+//a shard walks the starting positions of each rotor order in GrayWalk
+//order, so next counts candidates in that order: candidate begin + k of
+//an order is the one at rank k of its walk
+//the fingerprint identifies the search (the contents of its files, the
+//ciphertext and the parameters), so a checkpoint is never resumed into a
+//different search
+struct Checkpoint {
+
+  uint64_t fingerprint;
+  int shard;
+  int n_shards;
+  int n_rotors;
+
+  //first id of the shard, next candidate to try and one past the last id
+  uint64_t begin;
+  uint64_t next;
+  uint64_t end;
+
+  std::string plugboard;
+  std::vector<std::string> reflectors;
+  std::vector<std::string> rotors;
+
+  std::vector<KeyResult> results;
+
+  //function to write the checkpoint, replacing the file atomically
+  //returns errorcode
+  int write(const std::string& path) const;
+
+  //function to read a checkpoint
+  //returns errorcode (ERROR_OPENING_CONFIGURATION_FILE if there is none,
+  //WRONG_FILE_VERSION if another version of keysearch wrote it)
+  int read(const std::string& path);
+
+};
+
+//trial decryption that gives up on a candidate part way through once a
+//sequential test shows that its index of coincidence is unlikely to reach
+//the score needed to enter the top results
+//after t letters the rate at which pairs of letters coincide estimates
+//score / 26 with a spread that shrinks as t grows (modelled on a text at
+//the threshold with the letter frequencies of English); the decryption
+//is checked after min_letters letters and then every TRIAL_CHUNK letters,
+//and abandoned when its rate is below the threshold rate by more than the
+//spread allows, with the chance of abandoning a candidate that would have
+//reached the threshold at most rejection over all the checks
+//a decryptor counts the candidates and letters it decrypts and belongs to
+//one thread
+class TrialDecryptor {
+
+  double rejection;
+  int min_letters;
+
+  //number of spreads below the threshold rate at which a decryption is
+  //abandoned, and the first letter count checked, for tested_length
+  //letters and tested_threshold
+  int tested_length = -1;
+  double tested_threshold = -1;
+  double bound;
+  int first_check;
+
+  //statistics
+  uint64_t candidates = 0;
+  uint64_t abandoned = 0;
+  uint64_t letters = 0;
+
+ public:
+
+  //rejection is the chance of abandoning a candidate at the threshold
+  //(0 decrypts every candidate in full)
+  TrialDecryptor(double rejection, int min_letters);
+
+  //function to score a decryption as score_decryption does, unless it is
+  //abandoned first
+  //threshold is the score the decryption must reach, as given by
+  //TopResults::threshold
+  //score receives the score (of the letters decrypted if abandoned)
+  //returns false if the decryption was abandoned
+  bool decrypt(BlockEngine& engine, MachineState machine,
+               const symbol cipher[], symbol plain[], int length,
+               double threshold, double& score);
+
+  //getter functions for statistics
+  uint64_t get_candidates() const;
+  uint64_t get_abandoned() const;
+  uint64_t get_letters() const;
+
+};
+
+//function to print a result as its score, reflector file, rotor files
+//and starting positions (so that it can be turned back into a command line)
+//space is the key space the result was found in and checkpoint holds the
+//file names of the search
+void print_result(std::ostream& out, const KeySpace& space,
+                  const Checkpoint& checkpoint, const KeyResult& result);
+
+//function to score a decryption by its index of coincidence
+//machine is copied, cipher[] holds length letters as indexes 0-25
+double score_decryption(MachineState machine, const uint8_t cipher[],
+                        int length);
+
+//function to score a decryption as above, through a BlockEngine for the
+//wiring of machine
+//cipher[] holds length letters as symbols and plain[] receives the
+//decryption
+double score_decryption(BlockEngine& engine, MachineState machine,
+                        const symbol cipher[], symbol plain[], int length);
+
+#endif
@@ -0,0 +1,274 @@
+#include <fstream>
+#include <iostream>
+#include <memory>
+#include <string>
+#include <vector>
+#include "enigma.h"
+#include "errors.h"
+#include "keysearch.h"
+#include "machine.h"
+#include "tools.h"
+
+//helper function to mix bytes into a 64-bit FNV-1a fingerprint
+static void fingerprint_bytes(uint64_t& hash, const void* data, size_t length)
+{
+  const unsigned char* bytes = static_cast<const unsigned char*>(data);
+  for (size_t i = 0; i < length; i++)
+    {
+      hash ^= bytes[i];
+      hash *= 1099511628211ULL;
+    }
+}
+
+//helper function to mix the length and contents of a file into a
+//fingerprint
+//returns false if the file cannot be read
+static bool fingerprint_file(uint64_t& hash, const char path[])
+{
+  std::ifstream in(path, std::ios::binary);
+  if (in.fail())
+    return false;
+  std::string contents((std::istreambuf_iterator<char>(in)),
+                       std::istreambuf_iterator<char>());
+  if (in.bad())
+    return false;
+  uint64_t length = contents.size();
+  fingerprint_bytes(hash, &length, sizeof(length));
+  fingerprint_bytes(hash, contents.data(), contents.size());
+  return true;
+}
+
+static int usage()
+{
+  std::cerr << "usage: keysearch [-k rotors] [-f reflector-count] [-n top]"
+            << " [-i shard] [-s shards] [-c checkpoint-every]"
+            << " [-a abandon-one-in] [-m min-letters] checkpoint-file"
+            << " ciphertext-file plugboard-file (<reflector-file>)+"
+            << " (<rotor-file>)+\n";
+  return INSUFFICIENT_NUMBER_OF_PARAMETERS;
+}
+
+int main(int argc, char** argv)
+{
+  //-k rotors in the machine, -f number of reflector files, -n results
+  //kept, -i shard index, -s number of shards, -c candidates between
+  //checkpoints, -a chance (one in) of abandoning a decryption that would
+  //have made the top results (0, the default, decrypts every candidate in
+  //full), -m letters decrypted before a decryption may be abandoned
+  long options[8] = {3, 1, 10, 0, 1, 1000000, 0, 26};
+
+  int err = take_options(argc, argv, "kfniscam", options);
+  if (err != NO_ERROR)
+    {
+      cerr_tool(err);
+      return usage();
+    }
+
+  long n_rotors = options[0];
+  long n_reflectors = options[1];
+  long n_library = argc - 4 - n_reflectors;
+  if (n_rotors < 0 || n_rotors > MAX_ROTORS || n_reflectors < 1
+      || n_library < n_rotors || options[2] < 1 || options[4] < 1
+      || options[3] < 0 || options[3] >= options[4] || options[5] < 1
+      || options[6] < 0 || options[7] < 2)
+    return usage();
+
+  std::string checkpoint_file = argv[1];
+
+  std::vector<uint8_t> cipher;
+  std::ifstream cipher_in(argv[2]);
+  if (cipher_in.fail())
+    {
+      std::cerr << "Error opening ciphertext file " << argv[2] << "\n";
+      return ERROR_OPENING_CONFIGURATION_FILE;
+    }
+  err = read_message(cipher_in, cipher);
+  if (err != NO_ERROR)
+    {
+      cerr_tool(err);
+      return err;
+    }
+
+  //load every component once, the constructors report their own errors
+  Plugboard plugboard(argv[3]);
+  if (plugboard.get_pb_error() != NO_ERROR)
+    return plugboard.get_pb_error();
+
+  std::vector<const Reflector*> reflectors;
+  std::vector<const RotorWiring*> library;
+  err = NO_ERROR;
+  for (int i = 0; i < n_reflectors && err == NO_ERROR; i++)
+    {
+      reflectors.push_back(new Reflector(argv[4 + i]));
+      err = reflectors.back()->get_rf_error();
+    }
+  for (int i = 0; i < n_library && err == NO_ERROR; i++)
+    {
+      library.push_back(new RotorWiring(argv[4 + n_reflectors + i]));
+      err = library.back()->get_rot_error();
+    }
+
+  Checkpoint checkpoint;
+  KeySpace space(n_reflectors, n_library, n_rotors);
+
+  if (err == NO_ERROR)
+    {
+      checkpoint.shard = options[3];
+      checkpoint.n_shards = options[4];
+      checkpoint.n_rotors = n_rotors;
+      checkpoint.plugboard = argv[3];
+      for (int i = 0; i < n_reflectors; i++)
+        checkpoint.reflectors.push_back(argv[4 + i]);
+      for (int i = 0; i < n_library; i++)
+        checkpoint.rotors.push_back(argv[4 + n_reflectors + i]);
+
+      //the components are identified by what their files hold, so a
+      //search resumes wherever the files are, but not after one of them
+      //has been edited
+      uint64_t fingerprint = 14695981039346656037ULL;
+      fingerprint_bytes(fingerprint, &n_rotors, sizeof(n_rotors));
+      fingerprint_bytes(fingerprint, &n_reflectors, sizeof(n_reflectors));
+      fingerprint_bytes(fingerprint, &checkpoint.n_shards,
+                        sizeof(checkpoint.n_shards));
+      //abandoning changes which results are kept, so -a and -m are part
+      //of the search too
+      fingerprint_bytes(fingerprint, &options[6], sizeof(options[6]));
+      fingerprint_bytes(fingerprint, &options[7], sizeof(options[7]));
+      fingerprint_bytes(fingerprint, cipher.data(), cipher.size());
+      for (int i = 3; i < argc && err == NO_ERROR; i++)
+        if (!fingerprint_file(fingerprint, argv[i]))
+          {
+            std::cerr << "Error reading configuration file " << argv[i]
+                      << "\n";
+            err = ERROR_OPENING_CONFIGURATION_FILE;
+          }
+      checkpoint.fingerprint = fingerprint;
+
+      space.shard(checkpoint.shard, checkpoint.n_shards, checkpoint.begin,
+                  checkpoint.end);
+      checkpoint.next = checkpoint.begin;
+    }
+
+  //resume from an earlier run of the same shard of the same search
+  //a checkpoint file that cannot be read is left alone rather than
+  //overwritten, it may hold the progress of a long search
+  if (err == NO_ERROR)
+    {
+      Checkpoint earlier;
+      int read_err = earlier.read(checkpoint_file);
+      if (read_err == WRONG_FILE_VERSION)
+        {
+          std::cerr << "Checkpoint file " << checkpoint_file
+                    << " was written by another version of keysearch\n";
+          err = read_err;
+        }
+      else if (read_err != NO_ERROR
+               && read_err != ERROR_OPENING_CONFIGURATION_FILE)
+        {
+          std::cerr << "Checkpoint file " << checkpoint_file
+                    << " is damaged\n";
+          err = read_err;
+        }
+      else if (read_err == NO_ERROR)
+        {
+          if (earlier.fingerprint != checkpoint.fingerprint
+              || earlier.shard != checkpoint.shard
+              || earlier.begin != checkpoint.begin
+              || earlier.end != checkpoint.end)
+            {
+              std::cerr << "Checkpoint file " << checkpoint_file
+                        << " belongs to a different search\n";
+              err = INVALID_INDEX;
+            }
+          else
+            {
+              checkpoint.next = earlier.next;
+              checkpoint.results = earlier.results;
+              std::cerr << "resuming shard " << checkpoint.shard << " at "
+                        << checkpoint.next - checkpoint.begin << " of "
+                        << checkpoint.end - checkpoint.begin << "\n";
+            }
+        }
+    }
+
+  if (err == NO_ERROR)
+    {
+      TopResults top(options[2]);
+      for (const KeyResult& result : checkpoint.results)
+        top.add(result);
+
+      //the starting positions of each order are walked in Gray code
+      //order, so candidate k of an order is rank k of its walk
+      std::vector<symbol> cipher_symbols(cipher.size());
+      std::vector<symbol> plain(cipher.size());
+      for (size_t t = 0; t < cipher.size(); t++)
+        cipher_symbols[t] = cipher[t] + FIRST_SYMBOL;
+
+      TrialDecryptor trial(options[6] > 0 ? 1.0 / options[6] : 0,
+                           options[7]);
+      KeyLoader loader(space, plugboard, reflectors, library);
+      std::unique_ptr<BlockEngine> engine;
+      std::unique_ptr<GrayWalk> walk;
+      uint64_t since_checkpoint = 0;
+
+      for (uint64_t next = checkpoint.next; next < checkpoint.end; next++)
+        {
+          //the loader only moves to a new wiring when the order or
+          //reflector changes, the walk takes the positions from there
+          if (walk == nullptr || next % space.positions() == 0)
+            {
+              loader.load(next);
+              engine.reset(new BlockEngine(loader.get_wiring()));
+              walk.reset(new GrayWalk(loader.get_wiring(),
+                                      next % space.positions()));
+            }
+          else
+            walk->next();
+
+          uint64_t id = next - next % space.positions() + walk->get_index();
+          double score;
+          if (trial.decrypt(*engine, walk->get_machine(),
+                            cipher_symbols.data(), plain.data(),
+                            cipher.size(), top.threshold(), score))
+            top.add(KeyResult{score, id});
+
+          if (++since_checkpoint == (uint64_t) options[5])
+            {
+              checkpoint.next = next + 1;
+              checkpoint.results = top.sorted();
+              err = checkpoint.write(checkpoint_file);
+              if (err != NO_ERROR)
+                break;
+              since_checkpoint = 0;
+            }
+        }
+
+      if (err == NO_ERROR)
+        {
+          checkpoint.next = checkpoint.end;
+          checkpoint.results = top.sorted();
+          err = checkpoint.write(checkpoint_file);
+        }
+
+      if (trial.get_candidates() > 0)
+        std::cerr << trial.get_candidates() << " candidates tried, "
+                  << trial.get_abandoned() << " abandoned early, "
+                  << (double) trial.get_letters() / trial.get_candidates()
+                  << " of " << cipher.size() << " letters decrypted on"
+                  << " average\n";
+
+      if (err != NO_ERROR)
+        std::cerr << "Error writing checkpoint file " << checkpoint_file
+                  << "\n";
+      else
+        for (const KeyResult& result : checkpoint.results)
+          print_result(std::cout, space, checkpoint, result);
+    }
+
+  for (const Reflector* reflector : reflectors)
+    delete reflector;
+  for (const RotorWiring* rotor : library)
+    delete rotor;
+
+  return err;
+}
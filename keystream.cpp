@@ -0,0 +1,131 @@
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+#include <fcntl.h>
+#include <fstream>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include <vector>
+#include "errors.h"
+#include "keystream.h"
+
+//number of steps written at a time
+uint64_t const KEYSTREAM_BLOCK = 4096;
+
+int write_keystream(const std::string& path, MachineState machine,
+                    uint64_t steps)
+{
+  KeystreamHeader header;
+  std::memset(&header, 0, sizeof(header));
+  std::memcpy(header.magic, KEYSTREAM_MAGIC, sizeof(header.magic));
+  header.alphabet = ALPHA_SIZE;
+  header.n_rotors = machine.wiring->n_rotors;
+  header.steps = steps;
+  header.fingerprint = machine.wiring->fingerprint;
+  std::memcpy(header.position, machine.position, header.n_rotors);
+
+  std::string temporary = path + ".tmp";
+  std::ofstream out(temporary, std::ios::binary);
+  if (out.fail())
+    return ERROR_OPENING_CONFIGURATION_FILE;
+  out.write((const char*) &header, sizeof(header));
+
+  std::vector<uint8_t> block(KEYSTREAM_BLOCK * ALPHA_SIZE);
+  for (uint64_t done = 0; done < steps && out.good(); )
+    {
+      uint64_t count = std::min(KEYSTREAM_BLOCK, steps - done);
+      for (uint64_t t = 0; t < count; t++)
+        {
+          machine.keypress();
+          machine.permutation(&block[t * ALPHA_SIZE]);
+        }
+      out.write((const char*) block.data(), count * ALPHA_SIZE);
+      done += count;
+    }
+
+  out.close();
+  if (out.fail())
+    return ERROR_OPENING_CONFIGURATION_FILE;
+
+  //rename is atomic, so readers see either the old or the new keystream
+  if (std::rename(temporary.c_str(), path.c_str()) != 0)
+    return ERROR_OPENING_CONFIGURATION_FILE;
+
+  return NO_ERROR;
+}
+
+Keystream::Keystream(const std::string& path)
+{
+  int fd = open(path.c_str(), O_RDONLY);
+  if (fd < 0)
+    {
+      errorcode = ERROR_OPENING_CONFIGURATION_FILE;
+      return;
+    }
+
+  struct stat status;
+  if (fstat(fd, &status) != 0 || (size_t) status.st_size < sizeof(*header))
+    {
+      close(fd);
+      errorcode = NON_NUMERIC_CHARACTER;
+      return;
+    }
+
+  size = status.st_size;
+  memory = mmap(nullptr, size, PROT_READ, MAP_SHARED, fd, 0);
+  close(fd);
+  if (memory == MAP_FAILED)
+    {
+      memory = nullptr;
+      errorcode = ERROR_OPENING_CONFIGURATION_FILE;
+      return;
+    }
+  madvise(memory, size, MADV_SEQUENTIAL);
+
+  header = (const KeystreamHeader*) memory;
+  perms = (const uint8_t*) memory + sizeof(*header);
+  if (std::memcmp(header->magic, KEYSTREAM_MAGIC, sizeof(header->magic)) != 0
+      || header->alphabet != ALPHA_SIZE
+      || header->steps > (size - sizeof(*header)) / ALPHA_SIZE)
+    errorcode = NON_NUMERIC_CHARACTER;
+}
+
+Keystream::~Keystream()
+{
+  if (memory != nullptr)
+    munmap(memory, size);
+}
+
+uint64_t Keystream::get_steps() const
+{
+  return errorcode == NO_ERROR ? header->steps : 0;
+}
+
+const KeystreamHeader& Keystream::get_header() const
+{
+  return *header;
+}
+
+const uint8_t* Keystream::permutation(uint64_t step) const
+{
+  return perms + step * ALPHA_SIZE;
+}
+
+int Keystream::encrypt(uint64_t offset, const symbol in[], symbol out[],
+                       size_t length) const
+{
+  if (offset > get_steps() || length > get_steps() - offset)
+    return INVALID_INDEX;
+
+  const uint8_t* perm = permutation(offset);
+  for (size_t i = 0; i < length; i++, perm += ALPHA_SIZE)
+    out[i] = perm[in[i] - FIRST_SYMBOL] + FIRST_SYMBOL;
+
+  return NO_ERROR;
+}
+
+int Keystream::get_keystream_error() const
+{
+  return errorcode;
+}
@@ -0,0 +1,77 @@
+#ifndef KEYSTREAM_H
+#define KEYSTREAM_H
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include "machine.h"
+
+//magic string at the start of a keystream file
+#define KEYSTREAM_MAGIC "ENKSTRM1"
+
+//header of a keystream file, followed by steps permutations of
+//alphabet bytes each: permutation t is the one the machine applies to the
+//letter typed at step t (counting from 0 at the starting positions)
+struct KeystreamHeader {
+
+  char magic[8];
+  uint32_t alphabet;
+  uint32_t n_rotors;
+  uint64_t steps;
+
+  //Wiring::fingerprint of the machine and its starting positions
+  uint64_t fingerprint;
+  uint8_t position[MAX_ROTORS];
+
+};
+
+//function to write the keystream of a machine for a number of steps,
+//replacing the file atomically
+//machine is copied and stepped, no plaintext is needed
+//returns errorcode
+int write_keystream(const std::string& path, MachineState machine,
+                    uint64_t steps);
+
+//keystream file mapped into memory
+//encrypting at an offset only indexes the file: no rotor is stepped
+class Keystream {
+
+  int errorcode = NO_ERROR;
+
+  //mapping of the whole file
+  void* memory = nullptr;
+  size_t size = 0;
+
+  const KeystreamHeader* header = nullptr;
+  const uint8_t* perms = nullptr;
+
+ public:
+
+  //path is the keystream file to map
+  Keystream(const std::string& path);
+  Keystream(const Keystream&) = delete;
+  Keystream& operator=(const Keystream&) = delete;
+  ~Keystream();
+
+  //getter function for the number of steps in the file
+  uint64_t get_steps() const;
+
+  //getter function for the header (positions and fingerprint of the key)
+  const KeystreamHeader& get_header() const;
+
+  //function to get the permutation at a step
+  //returns ALPHA_SIZE indexes
+  const uint8_t* permutation(uint64_t step) const;
+
+  //function to encrypt (or decrypt) a message starting offset steps
+  //after the starting positions of the key
+  //in and out may be the same buffer
+  //returns errorcode (INVALID_INDEX if the file is too short)
+  int encrypt(uint64_t offset, const symbol in[], symbol out[],
+              size_t length) const;
+
+  //getter function for errorcode
+  int get_keystream_error() const;
+
+};
+
+#endif
@@ -0,0 +1,86 @@
+#include <iostream>
+#include <string>
+#include <vector>
+#include "enigma.h"
+#include "errors.h"
+#include "keystream.h"
+#include "machine.h"
+#include "tools.h"
+
+static int usage()
+{
+  std::cerr << "usage: keystream [-n steps] keystream-file plugboard-file"
+            << " reflector-file (<rotor-file>)* rotor-positions\n"
+            << "       keystream [-o offset] keystream-file < message\n";
+  return INSUFFICIENT_NUMBER_OF_PARAMETERS;
+}
+
+int main(int argc, char** argv)
+{
+  //-n steps to export, -o offset of the message from the key
+  long options[2] = {65536, 0};
+
+  int err = take_options(argc, argv, "no", options);
+  if (err != NO_ERROR)
+    {
+      cerr_tool(err);
+      return usage();
+    }
+  if (argc < 2 || argc == 3 || argc == 4 || options[0] < 0 || options[1] < 0)
+    return usage();
+
+  if (argc > 2)
+    {
+      //export: the configuration files follow the keystream file, which
+      //takes the place of the program name for Enigma
+      Enigma enigma(argc - 1, argv + 1, false);
+      if (enigma.get_enigma_error() != NO_ERROR)
+        return enigma.get_enigma_error();
+
+      Wiring wiring;
+      MachineState machine;
+      err = enigma.compile(wiring, machine);
+      if (err != NO_ERROR)
+        {
+          cerr_tool(err);
+          return err;
+        }
+
+      err = write_keystream(argv[1], machine, options[0]);
+      if (err != NO_ERROR)
+        std::cerr << "Error writing keystream file " << argv[1] << "\n";
+      return err;
+    }
+
+  Keystream keystream(argv[1]);
+  err = keystream.get_keystream_error();
+  if (err != NO_ERROR)
+    {
+      std::cerr << "Error reading keystream file " << argv[1] << "\n";
+      return err;
+    }
+
+  std::vector<uint8_t> message;
+  err = read_message(std::cin, message);
+  if (err != NO_ERROR)
+    {
+      cerr_tool(err);
+      return err;
+    }
+
+  std::string text(message.size(), ' ');
+  for (size_t i = 0; i < message.size(); i++)
+    text[i] = message[i] + 'A';
+
+  err = keystream.encrypt(options[1], (const symbol*) text.data(),
+                          (symbol*) &text[0], text.size());
+  if (err != NO_ERROR)
+    {
+      std::cerr << "Keystream file " << argv[1] << " ends before step "
+                << options[1] + text.size() << "\n";
+      return err;
+    }
+
+  std::cout << text;
+  return NO_ERROR;
+}
@@ -0,0 +1,200 @@
+#include <cstring>
+#include "errors.h"
+#include "machine.h"
+
+int Wiring::setup(const Plugboard& pb, const Reflector& rf,
+                  const RotorWiring* const rotors[], int n_rotors)
+{
+  if (n_rotors > MAX_ROTORS)
+    return TOO_MANY_ROTORS;
+
+  this->n_rotors = n_rotors;
+
+  for (int i = MIN_INDEX; i <= MAX_INDEX; i++)
+    {
+      plugboard[i] = pb.pb_encrypt(i + FIRST_SYMBOL) - FIRST_SYMBOL;
+      reflector[i] = rf.rf_encrypt(i + FIRST_SYMBOL) - FIRST_SYMBOL;
+    }
+
+  for (int r = 0; r < n_rotors; r++)
+    rotors[r]->compile(fw[r], bw[r], notch[r]);
+
+  fuse();
+
+  return NO_ERROR;
+}
+
+void Wiring::fuse()
+{
+  //64-bit FNV-1a over the components
+  fingerprint = 14695981039346656037ULL;
+  auto mix = [this](const uint8_t* bytes, size_t length)
+    {
+      for (size_t i = 0; i < length; i++)
+        {
+          fingerprint ^= bytes[i];
+          fingerprint *= 1099511628211ULL;
+        }
+    };
+  uint8_t rotors = n_rotors;
+  mix(&rotors, 1);
+  mix(plugboard, ALPHA_SIZE);
+  mix(reflector, ALPHA_SIZE);
+  for (int r = 0; r < n_rotors; r++)
+    {
+      mix(fw[r], ALPHA_SIZE);
+      mix(reinterpret_cast<const uint8_t*>(notch[r]), ALPHA_SIZE);
+    }
+
+  for (int r = 0; r < n_rotors; r++)
+    for (int p = MIN_INDEX; p <= MAX_INDEX; p++)
+      for (int i = MIN_INDEX; i <= MAX_INDEX; i++)
+        {
+          int input = (i + p) % ALPHA_SIZE;
+          fw_at[r][p][i] = (fw[r][input] + ALPHA_SIZE - p) % ALPHA_SIZE;
+          bw_at[r][p][i] = (bw[r][input] + ALPHA_SIZE - p) % ALPHA_SIZE;
+        }
+
+  if (n_rotors == 0)
+    {
+      for (int i = MIN_INDEX; i <= MAX_INDEX; i++)
+        turn[0][i] = plugboard[reflector[plugboard[i]]];
+      return;
+    }
+
+  int right = n_rotors - 1;
+  for (int p = MIN_INDEX; p <= MAX_INDEX; p++)
+    for (int i = MIN_INDEX; i <= MAX_INDEX; i++)
+      {
+        entry[p][i] = fw_at[right][p][plugboard[i]];
+        exit[p][i] = plugboard[bw_at[right][p][i]];
+        turn[p][i] = bw_at[0][p][reflector[fw_at[0][p][i]]];
+      }
+
+  //a single rotor is both the rightmost and the leftmost one, so the
+  //whole machine is folded into turn
+  if (n_rotors == 1)
+    for (int p = MIN_INDEX; p <= MAX_INDEX; p++)
+      {
+        uint8_t through[ALPHA_SIZE];
+        for (int i = MIN_INDEX; i <= MAX_INDEX; i++)
+          through[i] = exit[p][reflector[entry[p][i]]];
+        for (int i = MIN_INDEX; i <= MAX_INDEX; i++)
+          turn[p][i] = through[i];
+      }
+}
+
+void MachineState::start(const int starting_positions[])
+{
+  for (int r = 0; r < wiring->n_rotors; r++)
+    position[r] = 0;
+
+  for (int r = 0; r < wiring->n_rotors; r++)
+    for (int rotations_count = 0; rotations_count < starting_positions[r];
+         rotations_count++)
+      rotate(r);
+}
+
+void MachineState::keypress()
+{
+  if (wiring->n_rotors > 0)
+    rotate(wiring->n_rotors - 1);
+}
+
+void MachineState::rotate(int r)
+{
+  //walk left for as long as a rotor reaches one of its notches
+  while (r >= 0)
+    {
+      position[r]++;
+      if (position[r] == ALPHA_SIZE)
+        position[r] = 0;
+      if (!wiring->notch[r][position[r]])
+        return;
+      r--;
+    }
+}
+
+uint8_t MachineState::encrypt(uint8_t index)
+{
+  keypress();
+  return apply(index);
+}
+
+void MachineState::permutation(uint8_t perm[]) const
+{
+  for (int i = MIN_INDEX; i <= MAX_INDEX; i++)
+    perm[i] = apply(i);
+}
+
+uint8_t MachineState::apply(uint8_t index) const
+{
+  const Wiring& w = *wiring;
+  int n_rotors = w.n_rotors;
+
+  if (n_rotors <= 1)
+    return w.turn[n_rotors ? position[0] : 0][index];
+
+  int right = n_rotors - 1;
+  int letter = w.entry[position[right]][index];
+
+  for (int r = right - 1; r > 0; r--)
+    letter = w.fw_at[r][position[r]][letter];
+
+  letter = w.turn[position[0]][letter];
+
+  for (int r = 1; r < right; r++)
+    letter = w.bw_at[r][position[r]][letter];
+
+  return w.exit[position[right]][letter];
+}
+
+void MachineState::encrypt(const symbol in[], symbol out[], size_t length)
+{
+  for (size_t i = 0; i < length; i++)
+    out[i] = encrypt(in[i] - FIRST_SYMBOL) + FIRST_SYMBOL;
+}
+
+MachinePool::MachinePool(size_t block_size)
+  : block_size(block_size)
+{
+}
+
+MachinePool::~MachinePool()
+{
+  for (MachineState* block : blocks)
+    delete [] block;
+}
+
+void MachinePool::grow(size_t count)
+{
+  last_size = count > block_size ? count : block_size;
+  blocks.push_back(new MachineState[last_size]);
+  used = 0;
+}
+
+MachineState* MachinePool::allocate(size_t count)
+{
+  if (blocks.empty() || used + count > last_size)
+    grow(count);
+
+  MachineState* states = blocks.back() + used;
+  used += count;
+  return states;
+}
+
+MachineState* MachinePool::clone(const MachineState& state)
+{
+  MachineState* copy = allocate();
+  std::memcpy(copy, &state, sizeof(MachineState));
+  return copy;
+}
+
+void MachinePool::reset()
+{
+  for (MachineState* block : blocks)
+    delete [] block;
+  blocks.clear();
+  last_size = 0;
+  used = 0;
+}
@@ -0,0 +1,145 @@
+#ifndef MACHINE_H
+#define MACHINE_H
+#include <cstddef>
+#include <cstdint>
+#include <type_traits>
+#include <vector>
+#include "enigma.h"
+
+//maximum number of rotors a compact machine can hold
+int const MAX_ROTORS = 8;
+
+//read-only tables compiled from a configured Enigma
+//a single Wiring is shared by any number of machine states and is never
+//written after Enigma::compile, so it is safe to read from many threads
+//letters are represented as indexes 0-25 and rotors are stored leftmost
+//first
+struct Wiring {
+
+  int n_rotors;
+
+  //components as loaded: the plugboard, the reflector and the rotor
+  //mappings as they are at position 0
+  uint8_t plugboard[ALPHA_SIZE];
+  uint8_t reflector[ALPHA_SIZE];
+
+  uint8_t fw[MAX_ROTORS][ALPHA_SIZE];
+  uint8_t bw[MAX_ROTORS][ALPHA_SIZE];
+
+  //notch[r][p] is true if rotor r turns its left neighbour when it
+  //reaches position p
+  bool notch[MAX_ROTORS][ALPHA_SIZE];
+
+  //hash of the components above, set by fuse, so that machines built
+  //from the same components can be recognised (see KeystreamCache)
+  uint64_t fingerprint;
+
+  //tables built by fuse, indexed by rotor position then letter
+  //fw_at[r][p] and bw_at[r][p] are the mappings of rotor r at position p
+  //entry[p] is the plugboard followed by the rightmost rotor at position p
+  //and exit[p] the rightmost rotor coming back followed by the plugboard;
+  //turn[p] is the leftmost rotor at position p, the reflector and the
+  //leftmost rotor again, so a letter only takes n_rotors + 1 lookups
+  //with a single rotor turn[p] is the whole machine, and with no rotors
+  //turn[0] is the plugboard, reflector and plugboard
+  uint8_t fw_at[MAX_ROTORS][ALPHA_SIZE][ALPHA_SIZE];
+  uint8_t bw_at[MAX_ROTORS][ALPHA_SIZE][ALPHA_SIZE];
+  uint8_t entry[ALPHA_SIZE][ALPHA_SIZE];
+  uint8_t exit[ALPHA_SIZE][ALPHA_SIZE];
+  uint8_t turn[ALPHA_SIZE][ALPHA_SIZE];
+
+  //function to compile loaded components and fuse them
+  //rotors[] holds n_rotors rotor wirings, leftmost first
+  //returns errorcode
+  int setup(const Plugboard& pb, const Reflector& rf,
+            const RotorWiring* const rotors[], int n_rotors);
+
+  //function to build the fused tables from the components above
+  //must be called again whenever a component is changed
+  void fuse();
+
+};
+
+//compact machine state: the shared wiring and one position per rotor
+//the position of a rotor is also its rotation counter, so this is all the
+//state a machine has; it is trivially copyable and can be cloned with
+//memcpy or allocated in bulk from a MachinePool
+struct MachineState {
+
+  const Wiring* wiring;
+  uint8_t position[MAX_ROTORS];
+
+  //function to set the rotors to their starting positions, rotating them
+  //from position 0 exactly as Rotor::start does (so notches reached on the
+  //way turn the rotors on their left)
+  //starting_positions[] holds one position per rotor, leftmost first
+  void start(const int starting_positions[]);
+
+  //function to rotate the rotors when a key is pressed
+  void keypress();
+
+  //function to rotate rotor r, turning its left neighbour at a notch
+  void rotate(int r);
+
+  //function to send a letter through the machine at the current
+  //positions, without rotating the rotors
+  //index is the letter as an index 0-25
+  //returns encrypted letter as an index 0-25
+  uint8_t apply(uint8_t index) const;
+
+  //function to compute the whole permutation the machine applies at the
+  //current positions, without rotating the rotors
+  //perm[] receives ALPHA_SIZE indexes
+  void permutation(uint8_t perm[]) const;
+
+  //function to encrypt a letter, rotating the rotors first
+  //index is the letter as an index 0-25
+  //returns encrypted letter as an index 0-25
+  uint8_t encrypt(uint8_t index);
+
+  //function to encrypt a run of symbols, converting them to indexes
+  //only here at the boundary
+  //in and out may be the same buffer
+  void encrypt(const symbol in[], symbol out[], size_t length);
+
+};
+
+static_assert(std::is_trivially_copyable<MachineState>::value,
+              "MachineState must be copyable with memcpy");
+
+//arena for allocating machine states in bulk
+//states are carved out of large blocks and are only released all at once,
+//either by reset or when the pool is destroyed
+class MachinePool {
+
+  //number of states in each block
+  size_t block_size;
+
+  //allocated blocks, size of the last one and number of states used in it
+  std::vector<MachineState*> blocks;
+  size_t last_size = 0;
+  size_t used = 0;
+
+  //function to add a new block of at least count states
+  void grow(size_t count);
+
+ public:
+
+  MachinePool(size_t block_size = 65536);
+  ~MachinePool();
+
+  MachinePool(const MachinePool&) = delete;
+  MachinePool& operator=(const MachinePool&) = delete;
+
+  //function to allocate count contiguous, uninitialized states
+  MachineState* allocate(size_t count = 1);
+
+  //function to allocate a copy of an existing state
+  MachineState* clone(const MachineState& state);
+
+  //function to release every state allocated so far
+  void reset();
+
+};
+
+#endif
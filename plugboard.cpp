@@ -10,10 +10,10 @@ Plugboard::Plugboard(char configuration[])
 
 void Plugboard::initialize_pb_mapping()
 {
-  char letter;
+  symbol letter;
   for (int i = MIN_INDEX; i <= MAX_INDEX; i++)
     {
-      letter = i + 'A';
+      letter = i + FIRST_SYMBOL;
       pb_mapping[i] = letter;
     }
 }
@@ -76,8 +76,8 @@ int Plugboard::setup(char configuration[])
               //to itself
             }
 
-          char letter1 = input1 + 'A';
-          char letter2 = input2 + 'A';
+          symbol letter1 = input1 + FIRST_SYMBOL;
+          symbol letter2 = input2 + FIRST_SYMBOL;
           pb_mapping[input1]= letter2;
           pb_mapping[input2]= letter1; //store the values
 
@@ -122,7 +122,7 @@ int Plugboard::setup(char configuration[])
   return NO_ERROR;
 }
 
-bool Plugboard::repetition(int index, char letter)
+bool Plugboard::repetition(int index, symbol letter)
 {
   //check the array for double occurrences,
   //but ignore the value of the index passed
@@ -149,9 +149,9 @@ bool Plugboard::repetition(int index, char letter)
   return false;
 }
 
-char Plugboard::pb_encrypt(char letter)
+symbol Plugboard::pb_encrypt(symbol letter) const
 {
-  int index = letter - 'A';
+  int index = letter - FIRST_SYMBOL;
   letter = pb_mapping[index];
   return letter;
 }
@@ -182,7 +182,7 @@ void Plugboard::cerr_pb(int err, char configuration[])
     }
 }
 
-int Plugboard::get_pb_error()
+int Plugboard::get_pb_error() const
 {
   return errorcode;
 }
@@ -0,0 +1,209 @@
+#include <algorithm>
+#include <random>
+#include <thread>
+#include "plugsearch.h"
+
+PlugboardSearch::PlugboardSearch(const MachineState& start,
+                                 const uint8_t cipher[], int length,
+                                 int max_pairs)
+  : length(length), cipher(cipher, cipher + length),
+    scrambler(length * ALPHA_SIZE), max_pairs(max_pairs)
+{
+  //take the plugboard out of a private copy of the wiring
+  Wiring unplugged = *start.wiring;
+  for (int i = MIN_INDEX; i <= MAX_INDEX; i++)
+    unplugged.plugboard[i] = i;
+  unplugged.fuse();
+
+  MachineState machine = start;
+  machine.wiring = &unplugged;
+
+  for (int t = 0; t < length; t++)
+    {
+      machine.keypress();
+      machine.permutation(&scrambler[t * ALPHA_SIZE]);
+      by_cipher[cipher[t]].push_back(t);
+    }
+}
+
+double PlugboardSearch::score(const long counts[]) const
+{
+  if (length < 2)
+    return 0;
+
+  double sum = 0;
+  for (int i = MIN_INDEX; i <= MAX_INDEX; i++)
+    sum += counts[i] * (counts[i] - 1);
+  return sum * ALPHA_SIZE / ((double) length * (length - 1));
+}
+
+PlugboardResult PlugboardSearch::climb(unsigned seed) const
+{
+  std::mt19937 rng(seed);
+
+  //random starting plugboard with up to max_pairs pairs
+  uint8_t plug[ALPHA_SIZE];
+  uint8_t letters[ALPHA_SIZE];
+  for (int i = MIN_INDEX; i <= MAX_INDEX; i++)
+    plug[i] = letters[i] = i;
+  std::shuffle(letters, letters + ALPHA_SIZE, rng);
+  int pairs = rng() % (max_pairs + 1);
+  for (int i = 0; i < pairs; i++)
+    {
+      plug[letters[2*i]] = letters[2*i + 1];
+      plug[letters[2*i + 1]] = letters[2*i];
+    }
+
+  //decryption under the starting plugboard, with the positions of the
+  //ciphertext grouped by middle letter so they can be found for rescoring
+  std::vector<uint8_t> middle(length);
+  std::vector<uint8_t> plain(length);
+  std::vector<int> by_middle[ALPHA_SIZE];
+  std::vector<int> slot(length);
+  long counts[ALPHA_SIZE] = {0};
+
+  for (int t = 0; t < length; t++)
+    {
+      middle[t] = scrambler[t * ALPHA_SIZE + plug[cipher[t]]];
+      slot[t] = by_middle[middle[t]].size();
+      by_middle[middle[t]].push_back(t);
+      plain[t] = plug[middle[t]];
+      counts[plain[t]]++;
+    }
+
+  double best = score(counts);
+
+  //stamp[t] == round marks position t as already touched by this move
+  std::vector<int> stamp(length, 0);
+  int round = 0;
+  std::vector<int> touched;
+
+  bool improved = true;
+  while (improved)
+    {
+      improved = false;
+      for (int a = MIN_INDEX; a <= MAX_INDEX; a++)
+        for (int b = a + 1; b <= MAX_INDEX; b++)
+          {
+            //remove the pair a-b, or plug a to b after unplugging both
+            uint8_t trial[ALPHA_SIZE];
+            std::copy(plug, plug + ALPHA_SIZE, trial);
+            if (plug[a] == b)
+              {
+                trial[a] = a;
+                trial[b] = b;
+              }
+            else
+              {
+                trial[plug[a]] = plug[a];
+                trial[plug[b]] = plug[b];
+                trial[a] = b;
+                trial[b] = a;
+                int trial_pairs = 0;
+                for (int i = MIN_INDEX; i <= MAX_INDEX; i++)
+                  if (trial[i] != i)
+                    trial_pairs++;
+                if (trial_pairs > 2*max_pairs)
+                  continue;
+              }
+
+            int changed[4];
+            int n_changed = 0;
+            for (int letter : {a, b, (int) plug[a], (int) plug[b]})
+              if (trial[letter] != plug[letter]
+                  && std::find(changed, changed + n_changed, letter)
+                  == changed + n_changed)
+                changed[n_changed++] = letter;
+
+            round++;
+            touched.clear();
+            for (int i = 0; i < n_changed; i++)
+              {
+                for (int t : by_cipher[changed[i]])
+                  if (stamp[t] != round)
+                    {
+                      stamp[t] = round;
+                      touched.push_back(t);
+                    }
+                for (int t : by_middle[changed[i]])
+                  if (stamp[t] != round)
+                    {
+                      stamp[t] = round;
+                      touched.push_back(t);
+                    }
+              }
+
+            long trial_counts[ALPHA_SIZE];
+            std::copy(counts, counts + ALPHA_SIZE, trial_counts);
+            for (int t : touched)
+              {
+                trial_counts[plain[t]]--;
+                trial_counts[trial[scrambler[t * ALPHA_SIZE
+                                             + trial[cipher[t]]]]]++;
+              }
+
+            double trial_score = score(trial_counts);
+            if (trial_score <= best + 1e-12)
+              continue;
+
+            //accept the move and bring the touched positions up to date
+            std::copy(trial, trial + ALPHA_SIZE, plug);
+            std::copy(trial_counts, trial_counts + ALPHA_SIZE, counts);
+            best = trial_score;
+            improved = true;
+
+            for (int t : touched)
+              {
+                uint8_t new_middle = scrambler[t * ALPHA_SIZE
+                                               + plug[cipher[t]]];
+                if (new_middle != middle[t])
+                  {
+                    std::vector<int>& old_list = by_middle[middle[t]];
+                    old_list[slot[t]] = old_list.back();
+                    slot[old_list.back()] = slot[t];
+                    old_list.pop_back();
+                    slot[t] = by_middle[new_middle].size();
+                    by_middle[new_middle].push_back(t);
+                    middle[t] = new_middle;
+                  }
+                plain[t] = plug[middle[t]];
+              }
+          }
+    }
+
+  PlugboardResult result;
+  std::copy(plug, plug + ALPHA_SIZE, result.plugboard);
+  result.score = best;
+  return result;
+}
+
+PlugboardResult PlugboardSearch::search(int restarts, int threads,
+                                        unsigned seed)
+{
+  if (restarts < 1)
+    restarts = 1;
+  if (threads < 1)
+    threads = 1;
+
+  //every restart keeps its own result, so ties always go to the lowest
+  //restart whatever the number of threads
+  std::vector<PlugboardResult> results(restarts);
+  std::vector<std::thread> workers;
+
+  for (int w = 0; w < threads; w++)
+    workers.emplace_back([&, w]()
+      {
+        for (int i = w; i < restarts; i += threads)
+          results[i] = climb(seed + i);
+      });
+
+  for (std::thread& worker : workers)
+    worker.join();
+
+  PlugboardResult result = results[0];
+  for (int i = 1; i < restarts; i++)
+    if (results[i].score > result.score)
+      result = results[i];
+
+  return result;
+}
@@ -0,0 +1,66 @@
+#ifndef PLUGSEARCH_H
+#define PLUGSEARCH_H
+#include <cstdint>
+#include <vector>
+#include "machine.h"
+
+//best plugboard found by a search
+//plugboard[] maps every letter to its partner (or itself when unplugged),
+//letters are represented as indexes 0-25
+struct PlugboardResult {
+
+  uint8_t plugboard[ALPHA_SIZE];
+
+  //index of coincidence of the decryption under this plugboard
+  double score;
+
+};
+
+//hill climber recovering the plugboard for fixed rotors and positions
+//the rotors and reflector at step t form a fixed permutation S_t, so the
+//plaintext letter at t is P[S_t[P[c_t]]] for plugboard P; changing a pair
+//only affects the positions whose ciphertext letter or middle letter
+//S_t[P[c_t]] is one of the re-plugged letters, and only those positions are
+//rescored for each tried move
+class PlugboardSearch {
+
+  //number of ciphertext letters
+  int length;
+
+  //ciphertext as indexes 0-25
+  std::vector<uint8_t> cipher;
+
+  //scrambler permutation of every step, ALPHA_SIZE entries per step
+  std::vector<uint8_t> scrambler;
+
+  //positions of the ciphertext grouped by ciphertext letter
+  std::vector<int> by_cipher[ALPHA_SIZE];
+
+  //maximum number of plugged pairs
+  int max_pairs;
+
+  //helper function to score letter counts of a decryption
+  //returns the index of coincidence
+  double score(const long counts[]) const;
+
+ public:
+
+  //start is the machine at the positions the message was encrypted from,
+  //its plugboard is ignored
+  //cipher[] holds length letters as indexes 0-25
+  PlugboardSearch(const MachineState& start, const uint8_t cipher[],
+                  int length, int max_pairs);
+
+  //function to hill climb from a random plugboard until no single swap,
+  //addition or removal of a pair improves the score
+  //seed selects the random starting plugboard
+  PlugboardResult climb(unsigned seed) const;
+
+  //function to run restarts climbs spread over threads
+  //restart i always uses seed + i, so the result does not depend on the
+  //number of threads
+  PlugboardResult search(int restarts, int threads, unsigned seed);
+
+};
+
+#endif
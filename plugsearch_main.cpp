@@ -0,0 +1,62 @@
+#include <iostream>
+#include <thread>
+#include <vector>
+#include "enigma.h"
+#include "errors.h"
+#include "machine.h"
+#include "plugsearch.h"
+#include "tools.h"
+
+int main(int argc, char** argv)
+{
+  //-t threads, -r restarts, -p maximum pairs, -s seed
+  long options[4] = {(long) std::thread::hardware_concurrency(), 16, 10, 1};
+
+  int err = take_options(argc, argv, "trps", options);
+  if (err != NO_ERROR || options[2] < 0 || options[2] > ALPHA_SIZE/2)
+    {
+      cerr_tool(err);
+      std::cerr << "usage: plugsearch [-t threads] [-r restarts] [-p max-pairs]"
+                << " [-s seed] plugboard-file reflector-file (<rotor-file>)* "
+                << "rotor-positions < ciphertext\n";
+      return err != NO_ERROR ? err : INSUFFICIENT_NUMBER_OF_PARAMETERS;
+    }
+
+  //the plugboard file is loaded like any other but replaced by the search
+  Enigma enigma(argc, argv, false);
+  if (enigma.get_enigma_error() != NO_ERROR)
+    return enigma.get_enigma_error();
+
+  Wiring wiring;
+  MachineState start;
+  err = enigma.compile(wiring, start);
+  if (err != NO_ERROR)
+    {
+      cerr_tool(err);
+      return err;
+    }
+
+  std::vector<uint8_t> cipher;
+  err = read_message(std::cin, cipher);
+  if (err != NO_ERROR)
+    {
+      cerr_tool(err);
+      return err;
+    }
+
+  PlugboardSearch search(start, cipher.data(), cipher.size(), options[2]);
+  PlugboardResult best = search.search(options[1], options[0], options[3]);
+
+  //print the pairs in plugboard file format
+  bool first = true;
+  for (int i = MIN_INDEX; i <= MAX_INDEX; i++)
+    if (best.plugboard[i] > i)
+      {
+        std::cout << (first ? "" : " ") << i << " " << (int) best.plugboard[i];
+        first = false;
+      }
+  std::cout << "\n";
+  std::cerr << "index of coincidence " << best.score << "\n";
+
+  return NO_ERROR;
+}
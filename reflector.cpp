@@ -10,10 +10,10 @@ Reflector::Reflector(char configuration[])
 
 void Reflector::initialize_rf_mapping()
 {
-  char letter;
+  symbol letter;
   for (int i = MIN_INDEX; i <= MAX_INDEX; i++)
     {
-      letter = i + 'A';
+      letter = i + FIRST_SYMBOL;
       rf_mapping[i] = letter;
     }
 }
@@ -80,8 +80,8 @@ int Reflector::setup(char configuration[])
               //to itself
             }
 
-          char letter1 = input1 + 'A';
-          char letter2 = input2 + 'A';
+          symbol letter1 = input1 + FIRST_SYMBOL;
+          symbol letter2 = input2 + FIRST_SYMBOL;
           rf_mapping[input1]= letter2;
           rf_mapping[input2]= letter1; //store the values
 
@@ -115,7 +115,7 @@ int Reflector::setup(char configuration[])
           count++;
           in >> input1;
         }
-      if (count != 13*2)
+      if (count != ALPHA_SIZE)
         {
           cerr_rf(INCORRECT_NUMBER_OF_REFLECTOR_PARAMETERS, count,
                                configuration);
@@ -128,7 +128,7 @@ int Reflector::setup(char configuration[])
   return NO_ERROR;
 }
 
-bool Reflector::repetition(int index, char letter)
+bool Reflector::repetition(int index, symbol letter)
 {
   //check the array for double occurreces,
   //but ignore the value of the index passed
@@ -155,9 +155,9 @@ bool Reflector::repetition(int index, char letter)
   return false;
 }
 
-char Reflector::rf_encrypt(char letter)
+symbol Reflector::rf_encrypt(symbol letter) const
 {
-  int index = letter - 'A';
+  int index = letter - FIRST_SYMBOL;
   letter = rf_mapping[index];
   return letter;
 }
@@ -175,7 +175,7 @@ void Reflector::cerr_rf(int err, int count, char configuration[])
       if (count % 2)
         std::cerr << "Incorrect (odd) number of parameters in reflector file "
                   << configuration << "\n";
-      if (count < 13*2 && !(count % 2))
+      if (count < ALPHA_SIZE && !(count % 2))
         std::cerr << "Insufficient number of mappings in reflector file: "
                   << configuration << "\n";
       break;
@@ -192,7 +192,7 @@ void Reflector::cerr_rf(int err, int count, char configuration[])
     }
 }
 
-int Reflector::get_rf_error()
+int Reflector::get_rf_error() const
 {
   return errorcode;
 }
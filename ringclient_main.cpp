@@ -0,0 +1,92 @@
+#include <iostream>
+#include <string>
+#include "errors.h"
+#include "shmring.h"
+#include "tools.h"
+
+//helper function to print the ciphertext of the oldest message in flight
+//returns errorcode
+static int print_oldest(RingClient& client, int number)
+{
+  uint32_t length;
+  const symbol* text = client.receive(length);
+  if (text == nullptr)
+    {
+      if (client.get_ring_error() == INVALID_INPUT_CHARACTER)
+        std::cerr << "Message " << number << " has characters other than"
+                  << " upper case letters A-Z\n";
+      else
+        std::cerr << "Server stopped before message " << number
+                  << " was encrypted\n";
+      return client.get_ring_error();
+    }
+  std::cout.write((const char*) text, length);
+  std::cout << "\n";
+  client.release();
+  return NO_ERROR;
+}
+
+int main(int argc, char** argv)
+{
+  if (argc != 2)
+    {
+      std::cerr << "usage: ringclient segment-name < messages (one per"
+                << " line)\n";
+      return INSUFFICIENT_NUMBER_OF_PARAMETERS;
+    }
+
+  RingClient client(argv[1]);
+  if (client.get_ring_error() == INSUFFICIENT_NUMBER_OF_PARAMETERS)
+    {
+      std::cerr << "Every channel of shared memory segment " << argv[1]
+                << " is in use\n";
+      return client.get_ring_error();
+    }
+  if (client.get_ring_error() != NO_ERROR)
+    {
+      std::cerr << "Error attaching to shared memory segment " << argv[1]
+                << "\n";
+      return client.get_ring_error();
+    }
+
+  //lines are written straight into free slots, and the oldest message is
+  //only waited for when every slot is in use
+  int err = NO_ERROR;
+  int sent = 0;
+  int printed = 0;
+  std::string line;
+  while (err == NO_ERROR && std::getline(std::cin, line))
+    {
+      symbol* slot;
+      while (err == NO_ERROR && (slot = client.reserve()) == nullptr)
+        {
+          if (client.in_flight() == 0)
+            err = ERROR_READING_OR_WRITING_FILE;
+          else
+            err = print_oldest(client, ++printed);
+        }
+      if (err != NO_ERROR)
+        break;
+
+      //whitespace is skipped, anything else is checked by the server
+      uint32_t length = 0;
+      for (char letter : line)
+        if (letter != ' ' && letter != '\t' && letter != '\r')
+          {
+            if (length == SHM_SLOT_SIZE)
+              {
+                std::cerr << "Message " << sent + 1 << " is longer than "
+                          << SHM_SLOT_SIZE << " symbols\n";
+                return INVALID_INDEX;
+              }
+            slot[length++] = letter;
+          }
+      client.submit(length);
+      sent++;
+    }
+
+  while (err == NO_ERROR && printed < sent)
+    err = print_oldest(client, ++printed);
+
+  return err;
+}
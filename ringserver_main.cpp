@@ -0,0 +1,73 @@
+#include <csignal>
+#include <iostream>
+#include <thread>
+#include "enigma.h"
+#include "errors.h"
+#include "machine.h"
+#include "shmring.h"
+#include "tools.h"
+
+static int usage()
+{
+  std::cerr << "usage: ringserver [-c channels] [-s slots] segment-name"
+            << " plugboard-file reflector-file (<rotor-file>)*"
+            << " rotor-positions\n";
+  return INSUFFICIENT_NUMBER_OF_PARAMETERS;
+}
+
+int main(int argc, char** argv)
+{
+  //-c clients served at once, -s messages in flight per client
+  long options[2] = {4, 64};
+
+  int err = take_options(argc, argv, "cs", options);
+  if (err != NO_ERROR)
+    {
+      cerr_tool(err);
+      return usage();
+    }
+  if (argc < 5 || options[0] < 1 || options[0] > 1024 || options[1] < 1
+      || options[1] > 65536)
+    return usage();
+
+  //the segment name takes the place of the program name, the constructor
+  //reports configuration errors itself
+  Enigma enigma(argc - 1, argv + 1, false);
+  if (enigma.get_enigma_error() != NO_ERROR)
+    return enigma.get_enigma_error();
+
+  Wiring wiring;
+  MachineState start;
+  err = enigma.compile(wiring, start);
+  if (err != NO_ERROR)
+    {
+      cerr_tool(err);
+      return err;
+    }
+
+  //SIGINT and SIGTERM are taken by the main thread only, once the workers
+  //(which inherit the mask) are running
+  sigset_t signals;
+  sigemptyset(&signals);
+  sigaddset(&signals, SIGINT);
+  sigaddset(&signals, SIGTERM);
+  pthread_sigmask(SIG_BLOCK, &signals, nullptr);
+
+  RingServer server(argv[1], options[0], options[1], start);
+  if (server.get_ring_error() != NO_ERROR)
+    {
+      std::cerr << "Error creating shared memory segment " << argv[1] << "\n";
+      return server.get_ring_error();
+    }
+
+  std::thread serving(&RingServer::run, &server);
+  int signal;
+  sigwait(&signals, &signal);
+  server.stop();
+  serving.join();
+
+  std::cerr << server.get_messages() << " messages (" << server.get_symbols()
+            << " symbols) encrypted\n";
+
+  return NO_ERROR;
+}
@@ -0,0 +1,176 @@
+#include <iostream>
+#include <fstream>
+#include <string>
+#include "errors.h"
+#include "enigma.h"
+
+RotorWiring::RotorWiring(char configuration[])
+{
+  errorcode = setup(configuration);
+}
+
+int RotorWiring::setup(char configuration[])
+{
+  int input_values[2*ALPHA_SIZE]; //values from config file
+  initialize_rot_arrays(input_values);
+
+  std::ifstream in;
+  in.open(configuration);
+
+  //Start of validation
+  if (in.fail())
+    {
+      cerr_rot(ERROR_OPENING_CONFIGURATION_FILE, configuration);
+      return ERROR_OPENING_CONFIGURATION_FILE;
+    }
+
+  if (in)
+    {
+      int count = 0;
+      int input;
+      in >> input;
+      while (!in.eof())
+        {
+          if (in.fail())
+            {
+              cerr_rot(NON_NUMERIC_CHARACTER, configuration);
+              return NON_NUMERIC_CHARACTER;
+            }
+
+          if (input < MIN_INDEX || input > MAX_INDEX)
+            {
+              cerr_rot(INVALID_INDEX, configuration);
+              return INVALID_INDEX;
+            }
+
+          if (count < ALPHA_SIZE)
+            for (int i = 0; i < ALPHA_SIZE; i++)
+              if (input_values[i] == input)
+                {
+                  cerr_rot_map(count, input, i, configuration);
+                  return INVALID_ROTOR_MAPPING; //check if letter is mapped
+                  //already
+                }
+
+          input_values[count] = input; //store the value
+          
+          count++;
+          in >> input;
+        }
+      count--;
+      if (count < ALPHA_SIZE || count > 2*ALPHA_SIZE) //max 26 notches
+        {
+          cerr_rot_map(count, -1, -1, configuration);
+          return INVALID_ROTOR_MAPPING;
+        }
+    }
+  in.close();
+  //End of validation
+
+  //set up mappings
+  for (int i = 0; i <= MAX_INDEX; i++)
+    {
+      fw_map[i] = (input_values[i] - i);
+      bw_map[input_values[i]] = (i - input_values[i]);
+    }
+
+  //set up notches
+  for (int i = ALPHA_SIZE; i < 2*ALPHA_SIZE; i++)
+    if (input_values[i] != -1)
+      notch[input_values[i]] = true;
+  
+  return NO_ERROR;
+}
+
+void RotorWiring::initialize_rot_arrays(int input_values[])
+{
+  for (int i = MIN_INDEX; i < 2*ALPHA_SIZE; i++)
+    input_values[i] = -1; //null input
+  for (int i = MIN_INDEX; i < ALPHA_SIZE; i++)
+    {
+      fw_map[i] = i;
+      bw_map[i] = i;
+      notch[i] = false; //null notches
+    }
+}
+
+bool RotorWiring::is_notch(int position) const
+{
+  return notch[position];
+}
+
+void RotorWiring::compile(uint8_t fw[], uint8_t bw[], bool notches[]) const
+{
+  for (int i = MIN_INDEX; i <= MAX_INDEX; i++)
+    {
+      fw[i] = (ALPHA_SIZE + i + fw_map[i]) % ALPHA_SIZE;
+      bw[i] = (ALPHA_SIZE + i + bw_map[i]) % ALPHA_SIZE;
+      notches[i] = notch[i];
+    }
+}
+
+symbol RotorWiring::fw_encrypt(symbol letter, int position) const
+{
+  int index = letter - FIRST_SYMBOL;
+  //after k rotations the offset for index i is the one of input (i+k),
+  //works for both positive and negative offsets
+  int offset = fw_map[(index + position) % ALPHA_SIZE];
+  index = (ALPHA_SIZE + ((index + offset)%ALPHA_SIZE))%ALPHA_SIZE;
+  letter = index + FIRST_SYMBOL;
+  return letter;
+}
+
+symbol RotorWiring::bw_encrypt(symbol letter, int position) const
+{
+  int index = letter - FIRST_SYMBOL;
+  int offset = bw_map[(index + position) % ALPHA_SIZE];
+  index = (ALPHA_SIZE + ((index + offset)%ALPHA_SIZE))%ALPHA_SIZE;
+  letter = index + FIRST_SYMBOL;
+  return letter;
+}
+
+void RotorWiring::cerr_rot(int err, char configuration[])
+{
+  switch(err)
+    {
+    case NO_ERROR:
+      break;
+    case ERROR_OPENING_CONFIGURATION_FILE:
+      std::cerr << "Error opening rotor file" << configuration
+                << "\n";
+      break;
+    case NON_NUMERIC_CHARACTER:
+      std::cerr << "Non-numeric character for mapping in rotor file "
+                << configuration << "\n";
+      break;
+    case INVALID_INDEX:
+      std::cerr << "Invalid index in rotor file" << configuration
+                << "\n";
+    }
+}
+
+void RotorWiring::cerr_rot_map(int count, int output1, int output2,
+                                char configuration[])
+{
+  if (count < ALPHA_SIZE)
+    {
+      if (output1 != -1 && output2 != -1)
+        {
+          std::cerr << "Invalid mapping of input " << count << " to output "
+                    << output1 << " (output " << output1 << " is already mapped"
+                    << " to from input " << output2 << ") in rotor file: "
+                    << configuration << "\n";
+        }
+      else {
+        std::cerr << "Not all inputs mapped in rotor file: " << configuration
+                  << "\n";
+      }
+    }
+  if (count > 2*ALPHA_SIZE)
+    std::cerr << "Too many notches in rotor file " << configuration << "\n";
+}
+
+int RotorWiring::get_rot_error() const
+{
+  return errorcode;
+}
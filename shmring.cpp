@@ -0,0 +1,387 @@
+#include <algorithm>
+#include <cerrno>
+#include <climits>
+#include <csignal>
+#include <cstring>
+#include <ctime>
+#include <fcntl.h>
+#include <fstream>
+#include <linux/futex.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <sys/syscall.h>
+#include <thread>
+#include <unistd.h>
+#include <vector>
+#include "block.h"
+#include "shmring.h"
+
+//number of times a side polls before it goes to sleep
+int const SHM_SPIN = 256;
+
+//longest a side sleeps before checking for a stopped server
+long const SHM_SLEEP_NANOSECONDS = 100000000;
+
+//helper functions for futex waits and wake-ups across processes
+static void futex_wait(std::atomic<uint32_t>& word, uint32_t value)
+{
+  struct timespec timeout = {0, SHM_SLEEP_NANOSECONDS};
+  syscall(SYS_futex, (uint32_t*) &word, FUTEX_WAIT, value, &timeout,
+          nullptr, 0);
+}
+
+static void futex_wake(std::atomic<uint32_t>& word)
+{
+  syscall(SYS_futex, (uint32_t*) &word, FUTEX_WAKE, INT_MAX, nullptr,
+          nullptr, 0);
+}
+
+//helper function to wait until counter moves on from value or the server
+//stops, polling at first and then sleeping
+static void wait_change(std::atomic<uint32_t>& counter, uint32_t value,
+                        std::atomic<uint32_t>& sleeping,
+                        const std::atomic<uint32_t>& shutdown)
+{
+  for (int spin = 0; spin < SHM_SPIN; spin++)
+    if (counter.load(std::memory_order_acquire) != value
+        || shutdown.load(std::memory_order_relaxed))
+      return;
+
+  //the flag is raised before the last check, so a side that moves the
+  //counter afterwards sees it and wakes this one
+  sleeping.store(1);
+  if (counter.load() == value && !shutdown.load())
+    futex_wait(counter, value);
+  sleeping.store(0, std::memory_order_relaxed);
+}
+
+//helper function to move a counter on and wake the other side if it sleeps
+static void advance(std::atomic<uint32_t>& counter, uint32_t value,
+                    std::atomic<uint32_t>& sleeping)
+{
+  counter.store(value);
+  if (sleeping.load())
+    futex_wake(counter);
+}
+
+//helper function to check whether the client holding a channel is alive
+//(a zombie has died but is not yet reaped by its parent)
+static bool is_alive(uint32_t pid)
+{
+  if (kill(pid, 0) != 0 && errno == ESRCH)
+    return false;
+
+  std::ifstream status("/proc/" + std::to_string(pid) + "/stat");
+  std::string field;
+  for (int i = 0; i < 3 && status >> field; i++)
+    ;
+  return field != "Z";
+}
+
+//helper function to compute the size of a segment and where its parts are
+static size_t layout(uint32_t channels, uint32_t slots,
+                     size_t& channels_offset, size_t& slots_offset)
+{
+  channels_offset = (sizeof(ShmHeader) + 63) / 64 * 64;
+  slots_offset = channels_offset + channels * sizeof(ShmChannel);
+  return slots_offset + (size_t) channels * slots * sizeof(ShmSlot);
+}
+
+RingServer::RingServer(const std::string& name, int n_channels, int n_slots,
+                       const MachineState& start)
+  : name("/" + name), channel_count(n_channels), slot_count(n_slots),
+    start(start)
+{
+  size_t channels_offset, slots_offset;
+  size = layout(n_channels, n_slots, channels_offset, slots_offset);
+
+  //a segment left by a server that did not stop cleanly is replaced
+  shm_unlink(this->name.c_str());
+  int fd = shm_open(this->name.c_str(), O_CREAT | O_EXCL | O_RDWR, 0600);
+  if (fd < 0)
+    {
+      errorcode = ERROR_OPENING_CONFIGURATION_FILE;
+      return;
+    }
+  if (ftruncate(fd, size) != 0)
+    {
+      close(fd);
+      shm_unlink(this->name.c_str());
+      errorcode = ERROR_READING_OR_WRITING_FILE;
+      return;
+    }
+  memory = mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+  close(fd);
+  if (memory == MAP_FAILED)
+    {
+      memory = nullptr;
+      shm_unlink(this->name.c_str());
+      errorcode = ERROR_READING_OR_WRITING_FILE;
+      return;
+    }
+
+  //the new segment is zero-filled, so every counter and flag starts at 0;
+  //the magic is written last so that clients never see a half-made header
+  header = (ShmHeader*) memory;
+  channels = (ShmChannel*) ((char*) memory + channels_offset);
+  slots = (ShmSlot*) ((char*) memory + slots_offset);
+  header->alphabet = ALPHA_SIZE;
+  header->channels = n_channels;
+  header->slots = n_slots;
+  std::atomic_thread_fence(std::memory_order_release);
+  std::memcpy(header->magic, SHMRING_MAGIC, sizeof(header->magic));
+}
+
+RingServer::~RingServer()
+{
+  if (memory != nullptr)
+    {
+      munmap(memory, size);
+      shm_unlink(name.c_str());
+    }
+}
+
+void RingServer::serve(int c)
+{
+  ShmChannel& channel = channels[c];
+  ShmSlot* mine = slots + (size_t) c * slot_count;
+  BlockEngine engine(*start.wiring);
+  uint32_t done = channel.completed.load(std::memory_order_relaxed);
+
+  //the client can write its slot at any time, so a message is copied out
+  //before it is checked and only the checked copy is encrypted
+  std::vector<symbol> message(SHM_SLOT_SIZE);
+
+  while (!header->shutdown.load(std::memory_order_relaxed))
+    {
+      uint32_t submitted
+        = channel.submitted.load(std::memory_order_acquire);
+      if (submitted == done)
+        {
+          wait_change(channel.submitted, done, channel.server_sleeping,
+                      header->shutdown);
+          continue;
+        }
+
+      for (; done != submitted; done++)
+        {
+          ShmSlot& slot = mine[done % slot_count];
+          int32_t length = *(volatile int32_t*) &slot.length;
+          if (length >= 0 && length <= (int32_t) SHM_SLOT_SIZE)
+            std::memcpy(message.data(), slot.data, length);
+          if (length < 0 || length > (int32_t) SHM_SLOT_SIZE)
+            slot.length = -INVALID_INDEX;
+#ifndef BYTE_ALPHABET
+          else if (!std::all_of(message.data(), message.data() + length,
+                                [](symbol letter)
+                                {
+                                  return letter >= FIRST_SYMBOL
+                                    && letter < FIRST_SYMBOL + ALPHA_SIZE;
+                                }))
+            slot.length = -INVALID_INPUT_CHARACTER;
+#endif
+          else
+            {
+              MachineState machine = start;
+              engine.encrypt(machine, message.data(), message.data(), length);
+              std::memcpy(slot.data, message.data(), length);
+              symbols += length;
+            }
+          messages++;
+          advance(channel.completed, done + 1, channel.client_sleeping);
+        }
+    }
+}
+
+void RingServer::run()
+{
+  if (errorcode != NO_ERROR)
+    return;
+
+  std::vector<std::thread> workers;
+  for (uint32_t c = 0; c < channel_count; c++)
+    workers.emplace_back(&RingServer::serve, this, c);
+  for (std::thread& worker : workers)
+    worker.join();
+}
+
+void RingServer::stop()
+{
+  if (errorcode != NO_ERROR)
+    return;
+
+  header->shutdown.store(1);
+  for (uint32_t c = 0; c < channel_count; c++)
+    {
+      futex_wake(channels[c].submitted);
+      futex_wake(channels[c].completed);
+    }
+}
+
+uint64_t RingServer::get_messages() const
+{
+  return messages;
+}
+
+uint64_t RingServer::get_symbols() const
+{
+  return symbols;
+}
+
+int RingServer::get_ring_error() const
+{
+  return errorcode;
+}
+
+RingClient::RingClient(const std::string& name)
+{
+  int fd = shm_open(("/" + name).c_str(), O_RDWR, 0);
+  if (fd < 0)
+    {
+      errorcode = ERROR_OPENING_CONFIGURATION_FILE;
+      return;
+    }
+
+  struct stat status;
+  if (fstat(fd, &status) != 0 || (size_t) status.st_size < sizeof(ShmHeader))
+    {
+      close(fd);
+      errorcode = NON_NUMERIC_CHARACTER;
+      return;
+    }
+  size = status.st_size;
+  memory = mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+  close(fd);
+  if (memory == MAP_FAILED)
+    {
+      memory = nullptr;
+      errorcode = ERROR_READING_OR_WRITING_FILE;
+      return;
+    }
+
+  //the sizes are read once, later changes to the shared header are not
+  //trusted
+  header = (ShmHeader*) memory;
+  channel_count = header->channels;
+  slot_count = header->slots;
+  size_t channels_offset, slots_offset;
+  if (std::memcmp(header->magic, SHMRING_MAGIC, sizeof(header->magic)) != 0
+      || header->alphabet != ALPHA_SIZE || slot_count == 0
+      || layout(channel_count, slot_count, channels_offset, slots_offset)
+         != size)
+    {
+      errorcode = NON_NUMERIC_CHARACTER;
+      return;
+    }
+  std::atomic_thread_fence(std::memory_order_acquire);
+
+  //take the first free channel, or one whose client died without giving
+  //it back (a pid is only reused long after its process is gone)
+  ShmChannel* all = (ShmChannel*) ((char*) memory + channels_offset);
+  uint32_t pid = getpid();
+  for (uint32_t c = 0; c < channel_count && channel == nullptr; c++)
+    {
+      uint32_t owner = all[c].attached.load();
+      if (owner != 0 && is_alive(owner))
+        continue;
+      if (all[c].attached.compare_exchange_strong(owner, pid))
+        {
+          channel = &all[c];
+          slots = (ShmSlot*) ((char*) memory + slots_offset)
+            + (size_t) c * slot_count;
+        }
+    }
+  if (channel == nullptr)
+    {
+      errorcode = INSUFFICIENT_NUMBER_OF_PARAMETERS;
+      return;
+    }
+
+  //messages a previous client left in flight are finished before their
+  //slots are reused
+  submitted = channel->submitted.load(std::memory_order_acquire);
+  uint32_t completed;
+  while ((completed = channel->completed.load(std::memory_order_acquire))
+         != submitted && !header->shutdown.load())
+    wait_change(channel->completed, completed, channel->client_sleeping,
+                header->shutdown);
+  released = submitted;
+}
+
+RingClient::~RingClient()
+{
+  if (memory == nullptr)
+    return;
+
+  if (channel != nullptr)
+    {
+      uint32_t length;
+      while (in_flight() > 0 && !header->shutdown.load())
+        if (receive(length) != nullptr)
+          release();
+      channel->attached.store(0);
+    }
+  munmap(memory, size);
+}
+
+symbol* RingClient::reserve()
+{
+  if (channel == nullptr || in_flight() == slot_count
+      || header->shutdown.load(std::memory_order_relaxed))
+    return nullptr;
+  return slots[submitted % slot_count].data;
+}
+
+void RingClient::submit(uint32_t length)
+{
+  slots[submitted % slot_count].length = length;
+  submitted++;
+  advance(channel->submitted, submitted, channel->server_sleeping);
+}
+
+const symbol* RingClient::receive(uint32_t& length)
+{
+  length = 0;
+  if (channel == nullptr || in_flight() == 0)
+    return nullptr;
+
+  uint32_t completed;
+  while ((completed = channel->completed.load(std::memory_order_acquire))
+         == released)
+    {
+      if (header->shutdown.load())
+        {
+          errorcode = ERROR_READING_OR_WRITING_FILE;
+          return nullptr;
+        }
+      wait_change(channel->completed, completed, channel->client_sleeping,
+                  header->shutdown);
+    }
+
+  ShmSlot& slot = slots[released % slot_count];
+  if (slot.length < 0)
+    {
+      errorcode = -slot.length;
+      released++;
+      return nullptr;
+    }
+  errorcode = NO_ERROR;
+  length = slot.length;
+  return slot.data;
+}
+
+void RingClient::release()
+{
+  if (in_flight() > 0)
+    released++;
+}
+
+uint32_t RingClient::in_flight() const
+{
+  return submitted - released;
+}
+
+int RingClient::get_ring_error() const
+{
+  return errorcode;
+}
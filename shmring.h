@@ -0,0 +1,189 @@
+#ifndef SHMRING_H
+#define SHMRING_H
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include "errors.h"
+#include "machine.h"
+
+//magic string at the start of a shared ring segment
+#define SHMRING_MAGIC "ENSHMRG1"
+
+//largest message a slot holds, in symbols
+uint32_t const SHM_SLOT_SIZE = 4096;
+
+//state of a channel shared by one client (the producer) and one server
+//thread (the consumer)
+//the client fills slot submitted % slots and advances submitted, the
+//server encrypts that slot in place and advances completed, and the
+//client reads the ciphertext where it wrote the plaintext; a slot is free
+//again once the client has read it, which only the client needs to know
+//a side that runs out of work sleeps on the other side's counter with a
+//futex, after raising its sleeping flag so that the other side knows to
+//make the wake-up system call
+struct ShmChannel {
+
+  alignas(64) std::atomic<uint32_t> submitted;
+  std::atomic<uint32_t> server_sleeping;
+
+  alignas(64) std::atomic<uint32_t> completed;
+  std::atomic<uint32_t> client_sleeping;
+
+  //pid of the client holding the channel, 0 while it is free
+  alignas(64) std::atomic<uint32_t> attached;
+
+};
+
+//start of a segment, followed by the channels and then, for each channel,
+//its slots: a length (replaced by the server with -errorcode for a bad
+//message) and SHM_SLOT_SIZE symbols
+struct ShmHeader {
+
+  char magic[8];
+  uint32_t alphabet;
+  uint32_t channels;
+  uint32_t slots;
+
+  //non-zero once the server stops
+  std::atomic<uint32_t> shutdown;
+
+};
+
+struct ShmSlot {
+
+  int32_t length;
+  symbol data[SHM_SLOT_SIZE];
+
+};
+
+//encryption server over a POSIX shared memory segment (/dev/shm/name)
+//every channel is served by its own thread with its own machine, and each
+//message is encrypted from the starting positions, so that any message
+//can be decrypted on its own
+class RingServer {
+
+  std::string name;
+  void* memory = nullptr;
+  size_t size = 0;
+
+  ShmHeader* header;
+  ShmChannel* channels;
+  ShmSlot* slots;
+
+  //sizes of the segment, kept here since clients can write to the header
+  uint32_t channel_count;
+  uint32_t slot_count;
+
+  //machine at its starting positions, with the wiring it refers to
+  MachineState start;
+
+  std::atomic<uint64_t> messages{0};
+  std::atomic<uint64_t> symbols{0};
+
+  int errorcode = NO_ERROR;
+
+  //function run by the thread serving a channel
+  void serve(int channel);
+
+ public:
+
+  //name is the segment name (without the leading /), replaced if it
+  //exists; start is the machine messages are encrypted with, its wiring
+  //must outlive the server
+  RingServer(const std::string& name, int channels, int slots,
+             const MachineState& start);
+
+  //the segment is unmapped and removed
+  ~RingServer();
+
+  RingServer(const RingServer&) = delete;
+  RingServer& operator=(const RingServer&) = delete;
+
+  //function to serve every channel until stop is called
+  void run();
+
+  //function to make run return, safe to call from another thread
+  void stop();
+
+  //getter functions for statistics
+  uint64_t get_messages() const;
+  uint64_t get_symbols() const;
+
+  //getter function for errorcode
+  int get_ring_error() const;
+
+};
+
+//client of a RingServer, holding one of its channels
+//a channel left held by a client that died is taken over by the next
+//client that attaches
+//messages are written straight into the shared slots and their ciphertext
+//is read back in place, up to slots messages in flight:
+//  symbol* slot = client.reserve();   //nullptr when every slot is in use
+//  ...write length symbols to slot...
+//  client.submit(length);
+//  const symbol* text = client.receive(length);  //oldest message
+//  ...read length symbols of ciphertext...
+//  client.release();
+//a client belongs to one thread
+class RingClient {
+
+  void* memory = nullptr;
+  size_t size = 0;
+
+  ShmHeader* header;
+  ShmChannel* channel = nullptr;
+  ShmSlot* slots;
+
+  //sizes of the segment as read when attaching
+  uint32_t channel_count;
+  uint32_t slot_count;
+
+  //messages submitted and released by this client
+  uint32_t submitted = 0;
+  uint32_t released = 0;
+
+  int errorcode = NO_ERROR;
+
+ public:
+
+  //name is the segment name given to the server
+  RingClient(const std::string& name);
+
+  //the channel is given back (after waiting for the messages in flight)
+  //and the segment unmapped
+  ~RingClient();
+
+  RingClient(const RingClient&) = delete;
+  RingClient& operator=(const RingClient&) = delete;
+
+  //function to get the slot for the next message
+  //returns nullptr if every slot holds a message not yet released, or if
+  //the client is not attached
+  symbol* reserve();
+
+  //function to send the message written to the reserved slot
+  //length is at most SHM_SLOT_SIZE
+  void submit(uint32_t length);
+
+  //function to wait for the ciphertext of the oldest message not yet
+  //released, sleeping if the server has not finished it
+  //length receives its length
+  //returns the ciphertext, to be freed with release once read, or nullptr
+  //(with errorcode set) if the server rejected the message, whose slot is
+  //then freed already, or stopped
+  const symbol* receive(uint32_t& length);
+
+  //function to free the slot of the oldest message
+  void release();
+
+  //getter function for the number of messages submitted and not released
+  uint32_t in_flight() const;
+
+  //getter function for errorcode (of attaching, or of the last receive)
+  int get_ring_error() const;
+
+};
+
+#endif
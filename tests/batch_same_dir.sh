@@ -0,0 +1,40 @@
+#!/bin/sh
+#batch must refuse an output directory that is its input directory, however
+#it is named, and leave the input files as they were
+#run from the top directory after make: sh tests/batch_same_dir.sh
+
+KEY="plugboards/I.pb reflectors/I.rf rotors/I.rot rotors/II.rot rotors/III.rot rotors/I.pos"
+WORK=$(mktemp -d) || exit 1
+trap 'rm -rf "$WORK"' EXIT
+
+mkdir "$WORK/same"
+echo HELLOWORLD > "$WORK/same/message.txt"
+ln -s same "$WORK/link"
+
+failed=0
+for output in "$WORK/same" "$WORK/same/" "$WORK/link"
+do
+  if ./batch -t 1 "$WORK/same" "$output" $KEY > /dev/null 2>&1
+  then
+    echo "FAIL: batch accepted $output as the output directory"
+    failed=1
+  fi
+  if [ "$(cat "$WORK/same/message.txt")" != HELLOWORLD ]
+  then
+    echo "FAIL: batch changed its input with $output as the output directory"
+    failed=1
+  fi
+done
+
+#a separate output directory still gets the encryption enigma gives, and no
+#temporary file is left behind
+./batch -t 1 "$WORK/same" "$WORK/out" $KEY > /dev/null || failed=1
+if [ "$(cat "$WORK/out/message.txt")" != "$(./enigma $KEY < "$WORK/same/message.txt")" ] \
+  || [ -e "$WORK/out/message.txt.tmp" ]
+then
+  echo "FAIL: batch output differs from enigma"
+  failed=1
+fi
+
+[ $failed = 0 ] && echo "ok batch_same_dir"
+exit $failed
@@ -0,0 +1,73 @@
+#include <cctype>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include "errors.h"
+#include "machine.h"
+#include "tools.h"
+
+int read_message(std::istream& in, std::vector<uint8_t>& message)
+{
+  char letter;
+  while (in.get(letter))
+    {
+      if (std::isspace((unsigned char) letter))
+        continue;
+      if (letter < 'A' || letter > 'Z')
+        {
+          std::cerr << letter;
+          return INVALID_INPUT_CHARACTER;
+        }
+      message.push_back(letter - 'A');
+    }
+  return NO_ERROR;
+}
+
+int take_options(int& argc, char**& argv, const char options[],
+                 long values[])
+{
+  int taken = 0;
+  while (1 + taken + 1 < argc && argv[1 + taken][0] == '-')
+    {
+      const char* option = argv[1 + taken];
+      const char* found = std::strchr(options, option[1]);
+      if (option[1] == '\0' || option[2] != '\0' || found == nullptr)
+        return INSUFFICIENT_NUMBER_OF_PARAMETERS;
+
+      char* end;
+      long value = std::strtol(argv[2 + taken], &end, 10);
+      if (*end != '\0')
+        return NON_NUMERIC_CHARACTER;
+
+      values[found - options] = value;
+      taken += 2;
+    }
+
+  //keep the program name in front of the remaining arguments
+  argv[taken] = argv[0];
+  argv += taken;
+  argc -= taken;
+  return NO_ERROR;
+}
+
+void cerr_tool(int err)
+{
+  switch(err)
+    {
+    default:
+      break;
+    case TOO_MANY_ROTORS:
+      std::cerr << "Too many rotors (at most " << MAX_ROTORS
+                << " are supported)\n";
+      break;
+    case INVALID_INPUT_CHARACTER:
+      std::cerr << " is not a valid input character (input characters must be u"
+                << "pper case letters A-Z)!\n";
+      break;
+    case NON_NUMERIC_CHARACTER:
+      std::cerr << "Non-numeric option value\n";
+      break;
+    case INSUFFICIENT_NUMBER_OF_PARAMETERS:
+      std::cerr << "Unknown option\n";
+    }
+}
@@ -0,0 +1,28 @@
+#ifndef TOOLS_H
+#define TOOLS_H
+#include <cstdint>
+#include <iostream>
+#include <vector>
+#include "enigma.h"
+
+//helper functions shared by the command line tools
+
+//function to read a message from an input stream as indexes 0-25,
+//skipping whitespace
+//message receives the letters
+//returns errorcode (INVALID_INPUT_CHARACTER if anything else is found)
+int read_message(std::istream& in, std::vector<uint8_t>& message);
+
+//function to take leading "-x value" options off the command line, leaving
+//argv[0] as the program name followed by the remaining arguments
+//options[] lists the accepted option letters and values[] receives their
+//values in the same order (left unchanged for absent options)
+//returns errorcode (INSUFFICIENT_NUMBER_OF_PARAMETERS on a bad option)
+int take_options(int& argc, char**& argv, const char options[],
+                 long values[]);
+
+//function to print the message for an errorcode returned by
+//Enigma::compile or read_message (setup errors are printed by Enigma)
+void cerr_tool(int err);
+
+#endif
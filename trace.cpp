@@ -0,0 +1,113 @@
+#include "trace.h"
+
+#ifdef ENIGMA_TRACE
+#include <atomic>
+#include <csignal>
+#include <cstdlib>
+#include <cstring>
+#include <fcntl.h>
+#include <unistd.h>
+#include "enigma.h"
+
+//ring buffer: head counts every record ever written and stamps[i] holds the
+//sequence number + 1 of the record in slot i once it is completely written
+static TraceRecord records[TRACE_CAPACITY];
+static std::atomic<uint64_t> stamps[TRACE_CAPACITY];
+static std::atomic<uint64_t> head(0);
+
+//dump file from ENIGMA_TRACE_FILE, read once at start-up
+static const char* dump_path = nullptr;
+
+void trace_record(const TraceRecord& record)
+{
+  uint64_t sequence = head.fetch_add(1, std::memory_order_relaxed);
+  uint64_t slot = sequence & (TRACE_CAPACITY - 1);
+
+  //mark the slot as being written, then publish it with its stamp
+  stamps[slot].store(0, std::memory_order_relaxed);
+  std::atomic_thread_fence(std::memory_order_release);
+  records[slot] = record;
+  records[slot].sequence = sequence;
+  stamps[slot].store(sequence + 1, std::memory_order_release);
+}
+
+//helper function to write a whole buffer, retrying short writes
+static int write_all(int fd, const void* buffer, size_t length)
+{
+  const char* bytes = static_cast<const char*>(buffer);
+  while (length > 0)
+    {
+      ssize_t written = write(fd, bytes, length);
+      if (written < 0)
+        return -1;
+      bytes += written;
+      length -= written;
+    }
+  return 0;
+}
+
+int trace_dump(const char path[])
+{
+  int fd = open(path, O_WRONLY | O_CREAT | O_TRUNC, 0644);
+  if (fd < 0)
+    return -1;
+
+  uint64_t last = head.load(std::memory_order_acquire);
+  uint64_t first = last > (uint64_t) TRACE_CAPACITY
+    ? last - TRACE_CAPACITY : 0;
+
+  //records that are torn or overwritten while dumping are left out, so the
+  //count is only known at the end and the header is written last
+  TraceHeader header;
+  std::memcpy(header.magic, TRACE_MAGIC, sizeof(header.magic));
+  header.record_size = sizeof(TraceRecord);
+  header.trace_rotors = TRACE_ROTORS;
+  header.count = 0;
+  header.dropped = first;
+  header.alphabet = ALPHA_SIZE;
+  header.reserved = 0;
+
+  int status = write_all(fd, &header, sizeof(header));
+  for (uint64_t sequence = first; sequence < last && status == 0; sequence++)
+    {
+      uint64_t slot = sequence & (TRACE_CAPACITY - 1);
+      if (stamps[slot].load(std::memory_order_acquire) != sequence + 1)
+        continue;
+      TraceRecord copy = records[slot];
+      std::atomic_thread_fence(std::memory_order_acquire);
+      if (stamps[slot].load(std::memory_order_relaxed) != sequence + 1)
+        continue;
+      status = write_all(fd, &copy, sizeof(copy));
+      header.count++;
+    }
+
+  if (status == 0 && lseek(fd, 0, SEEK_SET) == 0)
+    status = write_all(fd, &header, sizeof(header));
+
+  close(fd);
+  return status;
+}
+
+static void dump_at_exit()
+{
+  trace_dump(dump_path);
+}
+
+static void dump_on_signal(int)
+{
+  trace_dump(dump_path);
+}
+
+//registers the exit and signal dumps before main runs
+static struct TraceSetup {
+  TraceSetup()
+  {
+    dump_path = std::getenv("ENIGMA_TRACE_FILE");
+    if (dump_path == nullptr)
+      return;
+    std::atexit(dump_at_exit);
+    std::signal(SIGUSR1, dump_on_signal);
+  }
+} trace_setup;
+
+#endif
@@ -0,0 +1,78 @@
+#ifndef TRACE_H
+#define TRACE_H
+#include <cstdint>
+
+//per-character trace of the classic machine
+//when built with -DENIGMA_TRACE (make TRACE=1), Enigma::encrypt records
+//every character into an in-memory ring buffer that is dumped to the file
+//named by the ENIGMA_TRACE_FILE environment variable at exit, or at any
+//time on SIGUSR1; tracedump decodes the dumps
+//without ENIGMA_TRACE the TRACE macro expands to nothing, so tracing costs
+//nothing unless it is compiled in
+
+//number of rotors kept in a record (further rotors are not traced)
+int const TRACE_ROTORS = 8;
+
+//number of records kept in the ring buffer (a power of 2)
+int const TRACE_CAPACITY = 1 << 16;
+
+//one traced character, letters are stored as symbols
+//forward[] and backward[] hold the output of each rotor in the order the
+//letter passes through them (rightmost first going forward, leftmost first
+//coming back) and position[] the rotor positions rightmost first
+struct TraceRecord {
+
+  uint64_t sequence;
+
+  uint8_t input;
+  uint8_t plugboard;
+  uint8_t reflector;
+  uint8_t output;
+  uint8_t n_rotors;
+
+  uint8_t position[TRACE_ROTORS];
+  uint8_t forward[TRACE_ROTORS];
+  uint8_t backward[TRACE_ROTORS];
+
+};
+
+//header of a dump file, followed by count records oldest first
+struct TraceHeader {
+
+  char magic[8];
+  uint32_t record_size;
+  uint32_t trace_rotors;
+  uint64_t count;
+
+  //records written before the oldest one in the dump (overwritten)
+  uint64_t dropped;
+
+  //ALPHA_SIZE of the traced machine, as byte machines store raw bytes
+  uint32_t alphabet;
+  uint32_t reserved;
+
+};
+
+//magic bytes at the start of a dump file
+#define TRACE_MAGIC "ENTRACE2"
+
+#ifdef ENIGMA_TRACE
+
+#define TRACE(...) __VA_ARGS__
+
+//function to append a record to the ring buffer
+//safe to call from any number of threads, it never blocks
+void trace_record(const TraceRecord& record);
+
+//function to write the ring buffer to a file
+//only uses async-signal-safe calls so it can run from a signal handler
+//returns 0 on success, -1 on failure
+int trace_dump(const char path[]);
+
+#else
+
+#define TRACE(...)
+
+#endif
+
+#endif
@@ -0,0 +1,85 @@
+#include <cstring>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include "errors.h"
+#include "trace.h"
+
+//helper function to print a traced symbol: as a letter when the machine
+//works on letters, and as a hexadecimal byte when it works on bytes
+static void print_symbol(uint8_t value, uint32_t alphabet)
+{
+  if (alphabet == 26 && value >= 'A' && value <= 'Z')
+    std::cout << (char) value;
+  else if (alphabet == 26)
+    std::cout << (int) value;
+  else
+    std::cout << "0x" << std::hex << std::setw(2) << std::setfill('0')
+              << (int) value << std::dec << std::setfill(' ');
+}
+
+int main(int argc, char** argv)
+{
+  if (argc != 2)
+    {
+      std::cerr << "usage: tracedump trace-file\n";
+      return INSUFFICIENT_NUMBER_OF_PARAMETERS;
+    }
+
+  std::ifstream in(argv[1], std::ios::binary);
+  if (in.fail())
+    {
+      std::cerr << "Error opening trace file " << argv[1] << "\n";
+      return ERROR_OPENING_CONFIGURATION_FILE;
+    }
+
+  TraceHeader header;
+  if (!in.read((char*) &header, sizeof(header))
+      || std::memcmp(header.magic, TRACE_MAGIC, sizeof(header.magic)) != 0
+      || header.record_size != sizeof(TraceRecord)
+      || header.trace_rotors != TRACE_ROTORS
+      || (header.alphabet != 26 && header.alphabet != 256))
+    {
+      std::cerr << "Not a trace file (or written by another version): "
+                << argv[1] << "\n";
+      return WRONG_FILE_VERSION;
+    }
+
+  std::cout << "# " << header.count << " records, " << header.dropped
+            << " earlier records overwritten\n"
+            << "# sequence input plugboard [positions] [forward] reflector "
+            << "[backward] output\n";
+
+  TraceRecord record;
+  for (uint64_t i = 0; i < header.count
+         && in.read((char*) &record, sizeof(record)); i++)
+    {
+      int n_rotors = record.n_rotors;
+      std::cout << record.sequence << " ";
+      print_symbol(record.input, header.alphabet);
+      std::cout << " ";
+      print_symbol(record.plugboard, header.alphabet);
+      std::cout << " [";
+      for (int r = 0; r < n_rotors; r++)
+        std::cout << (r ? " " : "") << (int) record.position[r];
+      std::cout << "] [";
+      for (int r = 0; r < n_rotors; r++)
+        {
+          std::cout << (r ? " " : "");
+          print_symbol(record.forward[r], header.alphabet);
+        }
+      std::cout << "] ";
+      print_symbol(record.reflector, header.alphabet);
+      std::cout << " [";
+      for (int r = 0; r < n_rotors; r++)
+        {
+          std::cout << (r ? " " : "");
+          print_symbol(record.backward[r], header.alphabet);
+        }
+      std::cout << "] ";
+      print_symbol(record.output, header.alphabet);
+      std::cout << "\n";
+    }
+
+  return NO_ERROR;
+}
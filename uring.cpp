@@ -0,0 +1,284 @@
+#include <cerrno>
+#include <cstring>
+#include <fcntl.h>
+#include <linux/io_uring.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#include "errors.h"
+#include "uring.h"
+
+//helper functions for the system calls, which have no libc wrappers
+static int io_uring_setup(unsigned entries, io_uring_params* params)
+{
+  return syscall(__NR_io_uring_setup, entries, params);
+}
+
+static int io_uring_enter(int fd, unsigned to_submit, unsigned min_complete,
+                          unsigned flags)
+{
+  return syscall(__NR_io_uring_enter, fd, to_submit, min_complete, flags,
+                 nullptr, 0);
+}
+
+static int io_uring_register(int fd, unsigned opcode, const void* arg,
+                             unsigned count)
+{
+  return syscall(__NR_io_uring_register, fd, opcode, arg, count);
+}
+
+IoRing::IoRing(unsigned entries)
+  : entries(entries)
+{
+  io_uring_params params;
+  std::memset(&params, 0, sizeof(params));
+  ring_fd = io_uring_setup(entries, &params);
+  if (ring_fd < 0)
+    return;
+
+  sq_size = params.sq_off.array + params.sq_entries * sizeof(unsigned);
+  cq_size = params.cq_off.cqes + params.cq_entries * sizeof(io_uring_cqe);
+  sqe_size = params.sq_entries * sizeof(io_uring_sqe);
+
+  //kernels with a single mmap share one mapping between the two rings
+  bool single = params.features & IORING_FEAT_SINGLE_MMAP;
+  if (single && cq_size > sq_size)
+    sq_size = cq_size;
+
+  sq_memory = mmap(nullptr, sq_size, PROT_READ | PROT_WRITE,
+                   MAP_SHARED | MAP_POPULATE, ring_fd, IORING_OFF_SQ_RING);
+  cq_memory = single ? sq_memory
+    : mmap(nullptr, cq_size, PROT_READ | PROT_WRITE,
+           MAP_SHARED | MAP_POPULATE, ring_fd, IORING_OFF_CQ_RING);
+  sqe_memory = mmap(nullptr, sqe_size, PROT_READ | PROT_WRITE,
+                    MAP_SHARED | MAP_POPULATE, ring_fd, IORING_OFF_SQES);
+  if (sq_memory == MAP_FAILED || cq_memory == MAP_FAILED
+      || sqe_memory == MAP_FAILED)
+    {
+      //give up on the kernel ring, the fallback still works
+      if (sq_memory != MAP_FAILED)
+        munmap(sq_memory, sq_size);
+      if (!single && cq_memory != MAP_FAILED)
+        munmap(cq_memory, cq_size);
+      if (sqe_memory != MAP_FAILED)
+        munmap(sqe_memory, sqe_size);
+      sq_memory = cq_memory = sqe_memory = nullptr;
+      ::close(ring_fd);
+      ring_fd = -1;
+      return;
+    }
+
+  char* sq = (char*) sq_memory;
+  char* cq = (char*) cq_memory;
+  sq_head = (unsigned*) (sq + params.sq_off.head);
+  sq_tail = (unsigned*) (sq + params.sq_off.tail);
+  sq_mask = (unsigned*) (sq + params.sq_off.ring_mask);
+  sq_array = (unsigned*) (sq + params.sq_off.array);
+  cq_head = (unsigned*) (cq + params.cq_off.head);
+  cq_tail = (unsigned*) (cq + params.cq_off.tail);
+  cq_mask = (unsigned*) (cq + params.cq_off.ring_mask);
+  cqes = (io_uring_cqe*) (cq + params.cq_off.cqes);
+  sqes = (io_uring_sqe*) sqe_memory;
+  this->entries = params.sq_entries;
+
+  probe();
+}
+
+void IoRing::probe()
+{
+  //kernels that cannot be probed only have the first operations, of which
+  //the fixed reads and writes are used here
+  supported[IORING_OP_READ_FIXED] = true;
+  supported[IORING_OP_WRITE_FIXED] = true;
+
+  std::vector<char> memory(sizeof(io_uring_probe)
+                           + 256 * sizeof(io_uring_probe_op));
+  io_uring_probe* probe = (io_uring_probe*) memory.data();
+  if (io_uring_register(ring_fd, IORING_REGISTER_PROBE, probe, 256) < 0)
+    return;
+
+  for (int i = 0; i < probe->ops_len; i++)
+    supported[probe->ops[i].op] = probe->ops[i].flags & IO_URING_OP_SUPPORTED;
+}
+
+IoRing::~IoRing()
+{
+  if (ring_fd < 0)
+    return;
+  munmap(sqe_memory, sqe_size);
+  if (cq_memory != sq_memory)
+    munmap(cq_memory, cq_size);
+  munmap(sq_memory, sq_size);
+  ::close(ring_fd);
+}
+
+bool IoRing::is_native() const
+{
+  return ring_fd >= 0;
+}
+
+void IoRing::register_buffers(const iovec buffers[], unsigned count)
+{
+  this->buffers.assign(buffers, buffers + count);
+  registered = ring_fd >= 0
+    && io_uring_register(ring_fd, IORING_REGISTER_BUFFERS, buffers, count)
+       == 0;
+}
+
+int IoRing::enter(unsigned min_complete)
+{
+  while (true)
+    {
+      int submitted = io_uring_enter(ring_fd, queued, min_complete,
+                                     IORING_ENTER_GETEVENTS);
+      if (submitted < 0)
+        {
+          if (errno == EINTR)
+            continue;
+          return ERROR_READING_OR_WRITING_FILE;
+        }
+
+      //the kernel stops at an entry it cannot take yet, and does not wait
+      //then, so the rest are offered again
+      queued -= submitted;
+      if (queued == 0)
+        return NO_ERROR;
+      if (submitted == 0)
+        {
+          errno = EAGAIN;
+          return ERROR_READING_OR_WRITING_FILE;
+        }
+    }
+}
+
+io_uring_sqe* IoRing::next_entry(uint8_t opcode)
+{
+  io_uring_sqe* entry = nullptr;
+  if (ring_fd >= 0 && supported[opcode])
+    {
+      //the kernel consumes entries on io_uring_enter, so a full ring is
+      //handed over before queueing more; if it takes none of them, the
+      //operation goes to the fallback
+      unsigned tail = *sq_tail;
+      if (tail - __atomic_load_n(sq_head, __ATOMIC_ACQUIRE) == entries)
+        enter(0);
+      if (tail - __atomic_load_n(sq_head, __ATOMIC_ACQUIRE) < entries)
+        {
+          unsigned index = tail & *sq_mask;
+          entry = &sqes[index];
+          sq_array[index] = index;
+          __atomic_store_n(sq_tail, tail + 1, __ATOMIC_RELEASE);
+          queued++;
+        }
+    }
+
+  if (entry == nullptr)
+    {
+      fallback.emplace_back();
+      entry = &fallback.back();
+    }
+  std::memset(entry, 0, sizeof(*entry));
+  entry->opcode = opcode;
+  return entry;
+}
+
+void IoRing::openat(const char path[], int flags, mode_t mode, uint64_t tag)
+{
+  io_uring_sqe* entry = next_entry(IORING_OP_OPENAT);
+  entry->fd = AT_FDCWD;
+  entry->addr = (uint64_t) path;
+  entry->len = mode;
+  entry->open_flags = flags;
+  entry->user_data = tag;
+}
+
+void IoRing::read_fixed(int fd, void* buffer, unsigned length,
+                        uint64_t offset, int buffer_index, uint64_t tag)
+{
+  io_uring_sqe* entry
+    = next_entry(registered ? IORING_OP_READ_FIXED : IORING_OP_READ);
+  entry->fd = fd;
+  entry->addr = (uint64_t) buffer;
+  entry->len = length;
+  entry->off = offset;
+  entry->buf_index = buffer_index;
+  entry->user_data = tag;
+}
+
+void IoRing::write_fixed(int fd, const void* buffer, unsigned length,
+                         uint64_t offset, int buffer_index, uint64_t tag)
+{
+  io_uring_sqe* entry
+    = next_entry(registered ? IORING_OP_WRITE_FIXED : IORING_OP_WRITE);
+  entry->fd = fd;
+  entry->addr = (uint64_t) buffer;
+  entry->len = length;
+  entry->off = offset;
+  entry->buf_index = buffer_index;
+  entry->user_data = tag;
+}
+
+void IoRing::close(int fd, uint64_t tag)
+{
+  io_uring_sqe* entry = next_entry(IORING_OP_CLOSE);
+  entry->fd = fd;
+  entry->user_data = tag;
+}
+
+int IoRing::run(const io_uring_sqe& entry)
+{
+  int result = -1;
+  switch (entry.opcode)
+    {
+    case IORING_OP_OPENAT:
+      result = ::openat(entry.fd, (const char*) entry.addr, entry.open_flags,
+                        entry.len);
+      break;
+    case IORING_OP_READ_FIXED:
+    case IORING_OP_READ:
+      result = pread(entry.fd, (void*) entry.addr, entry.len, entry.off);
+      break;
+    case IORING_OP_WRITE_FIXED:
+    case IORING_OP_WRITE:
+      result = pwrite(entry.fd, (const void*) entry.addr, entry.len,
+                      entry.off);
+      break;
+    case IORING_OP_CLOSE:
+      result = ::close(entry.fd);
+      break;
+    default:
+      errno = EINVAL;
+    }
+  return result < 0 ? -errno : result;
+}
+
+int IoRing::submit_and_wait(std::vector<IoCompletion>& done)
+{
+  done.clear();
+
+  for (const io_uring_sqe& entry : fallback)
+    done.push_back({entry.user_data, run(entry)});
+  fallback.clear();
+  if (ring_fd < 0)
+    return NO_ERROR;
+
+  //there is only something to wait for if the fallback completed nothing;
+  //a kernel that is busy (with completions to reap first) or short of
+  //memory gets the entries it did not take on the next call
+  unsigned head = *cq_head;
+  if (queued > 0
+      || (done.empty() && head == __atomic_load_n(cq_tail, __ATOMIC_ACQUIRE)))
+    if (enter(done.empty() ? 1 : 0) != NO_ERROR && errno != EBUSY
+        && errno != EAGAIN)
+      return ERROR_READING_OR_WRITING_FILE;
+
+  unsigned tail = __atomic_load_n(cq_tail, __ATOMIC_ACQUIRE);
+  for (; head != tail; head++)
+    {
+      const io_uring_cqe& completion = cqes[head & *cq_mask];
+      done.push_back({completion.user_data, completion.res});
+    }
+  __atomic_store_n(cq_head, head, __ATOMIC_RELEASE);
+
+  return NO_ERROR;
+}
@@ -0,0 +1,120 @@
+#ifndef URING_H
+#define URING_H
+#include <cstdint>
+#include <vector>
+#include <sys/types.h>
+#include <sys/uio.h>
+
+//completion of an operation queued on an IoRing
+//tag is the value given when the operation was queued and result is the
+//return value of the equivalent system call (-errno on failure)
+struct IoCompletion {
+
+  uint64_t tag;
+  int result;
+
+};
+
+//minimal io_uring submission/completion ring over the raw system calls
+//operations are queued, submitted together and completed in any order;
+//when the kernel refuses io_uring (old kernels, seccomp filters) the ring
+//runs every operation as a plain system call when it is submitted, so
+//callers see the same completions either way
+//the same fallback is used operation by operation: for opcodes the kernel
+//does not support (as found by probing it), for entries the kernel does
+//not take when the ring is full, and for fixed reads and writes when the
+//buffers could not be registered (and plain reads and writes are not
+//supported either)
+//a ring belongs to one thread
+class IoRing {
+
+  int ring_fd = -1;
+
+  //shared ring memory
+  void* sq_memory = nullptr;
+  void* cq_memory = nullptr;
+  void* sqe_memory = nullptr;
+  size_t sq_size = 0;
+  size_t cq_size = 0;
+  size_t sqe_size = 0;
+
+  //pointers into the submission and completion rings
+  unsigned* sq_head;
+  unsigned* sq_tail;
+  unsigned* sq_mask;
+  unsigned* sq_array;
+  unsigned* cq_head;
+  unsigned* cq_tail;
+  unsigned* cq_mask;
+  struct io_uring_sqe* sqes;
+  struct io_uring_cqe* cqes;
+
+  unsigned entries;
+
+  //number of queued operations not yet handed to the kernel
+  unsigned queued = 0;
+
+  //supported[opcode] is true if the kernel runs that operation
+  bool supported[256] = {};
+
+  //registered buffers, kept for the fallback, and whether the kernel
+  //accepted them
+  std::vector<iovec> buffers;
+  bool registered = false;
+
+  //operations to run as system calls on the next submission
+  std::vector<struct io_uring_sqe> fallback;
+
+  //helper function to find which operations the kernel supports
+  void probe();
+
+  //helper function to hand the queued entries to the kernel, offering
+  //again those it did not take, and wait for min_complete completions
+  //returns errorcode (with errno set)
+  int enter(unsigned min_complete);
+
+  //helper function to get a cleared entry for an operation, in the kernel
+  //ring if it can run the operation (submitting queued entries first if the
+  //ring is full) and in the fallback otherwise
+  struct io_uring_sqe* next_entry(uint8_t opcode);
+
+  //helper function to run one operation as a system call
+  //returns the result of the call (-errno on failure)
+  int run(const struct io_uring_sqe& entry);
+
+ public:
+
+  //entries is the number of operations that can be queued at once
+  IoRing(unsigned entries);
+  IoRing(const IoRing&) = delete;
+  IoRing& operator=(const IoRing&) = delete;
+  ~IoRing();
+
+  //function to check whether the kernel ring is in use (false when
+  //operations run through the fallback)
+  bool is_native() const;
+
+  //function to register buffers for read_fixed and write_fixed
+  //if the kernel refuses them (for instance over RLIMIT_MEMLOCK) the fixed
+  //operations are run as plain reads and writes instead
+  void register_buffers(const iovec buffers[], unsigned count);
+
+  //functions to queue operations, completed with the given tag
+  //path must stay valid until the operation completes
+  //buffer must lie in the registered buffer with index buffer_index
+  void openat(const char path[], int flags, mode_t mode, uint64_t tag);
+  void read_fixed(int fd, void* buffer, unsigned length, uint64_t offset,
+                  int buffer_index, uint64_t tag);
+  void write_fixed(int fd, const void* buffer, unsigned length,
+                   uint64_t offset, int buffer_index, uint64_t tag);
+  void close(int fd, uint64_t tag);
+
+  //function to submit the queued operations and wait for at least one
+  //completion (some operation must be outstanding)
+  //done receives every completion available
+  //returns errorcode
+  int submit_and_wait(std::vector<IoCompletion>& done);
+
+};
+
+#endif